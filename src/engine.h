@@ -0,0 +1,739 @@
+/**
+ * @file engine.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Board representation and search engine shared by the game and the tools.
+    The board dimensions are fixed at compile time with BOARD_WIDTH and BOARD_WIN_LENGTH.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_ENGINE_H
+#define TIC_TAC_TOE_ENGINE_H
+
+// #region Header_Inclusion
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "search.h"
+#include "trace.h"
+// #endregion // Header_Inclusion
+
+// #region Pre-process_Definitions
+#ifndef BOARD_WIDTH
+#define BOARD_WIDTH 3
+#endif
+#ifndef BOARD_WIN_LENGTH
+#define BOARD_WIN_LENGTH BOARD_WIDTH
+#endif
+
+#ifndef max
+#define max(_a, _b) (((_a) > (_b)) ? (_a) : (_b))
+#endif
+#ifndef min
+#define min(_a, _b) (((_a) < (_b)) ? (_a) : (_b))
+#endif
+#define swap(_T, _a, _b) \
+    do {                 \
+        _T __t = (_a);   \
+        (_a)   = (_b);   \
+        (_b)   = __t;    \
+    } while (0)
+// #endregion // Pre-process_Definitions
+
+enum {
+    BOARD_SIZE          = BOARD_WIDTH * BOARD_WIDTH,
+    WIN_CONDITION_COUNT = 2 * BOARD_WIDTH * (BOARD_WIDTH - BOARD_WIN_LENGTH + 1) + 2 * (BOARD_WIDTH - BOARD_WIN_LENGTH + 1) * (BOARD_WIDTH - BOARD_WIN_LENGTH + 1),
+    ANALYSIS_CACHE_SIZE = 1 << 16,
+    ANALYSIS_SCORE_NONE = -2,
+    // every tile lies on at most BOARD_WIN_LENGTH lines per direction
+    CELL_WIN_CONDITION_MAX = 4 * BOARD_WIN_LENGTH,
+    // Search scores: proven results sit at +-(SCORE_WIN - ply), static evaluation is clamped well inside
+    SCORE_WIN           = 1000000,
+    SCORE_PROVEN        = SCORE_WIN - BOARD_SIZE - 1,
+    SCORE_HEURISTIC_MAX = SCORE_WIN / 10,
+    SCORE_INFINITY      = SCORE_WIN + 1,
+    // Proof-number search: table entries, the "infinite" proof/disproof number and node budgets per proof
+    PROOF_CACHE_SIZE         = 1 << 18,
+    PROOF_INFINITY           = 1 << 28,
+    PROOF_NODE_LIMIT         = 1 << 16,
+    PROOF_DEFENSE_NODE_LIMIT = 1 << 12,
+    // N-tuple evaluation: each tuple is a straight run or a two-row block as long as a win line (up to 6 tiles),
+    // indexing its own table of 3^NTUPLE_LENGTH weights. Indices are padded to a multiple of 8 with offsets of a zero weight.
+    NTUPLE_LENGTH       = BOARD_WIN_LENGTH < 6 ? BOARD_WIN_LENGTH : 6,
+    NTUPLE_BLOCK_LENGTH = (NTUPLE_LENGTH + 1) / 2,
+    NTUPLE_COUNT        = 2 * BOARD_WIDTH * (BOARD_WIDTH - NTUPLE_LENGTH + 1) + 2 * (BOARD_WIDTH - NTUPLE_LENGTH + 1) * (BOARD_WIDTH - NTUPLE_LENGTH + 1) + 2 * (BOARD_WIDTH - 1) * (BOARD_WIDTH - NTUPLE_BLOCK_LENGTH + 1),
+    NTUPLE_INDEX_COUNT  = (NTUPLE_COUNT + 7) / 8 * 8,
+    NTUPLE_TABLE_SIZE   = NTUPLE_LENGTH == 2 ? 9 : (NTUPLE_LENGTH == 3 ? 27 : (NTUPLE_LENGTH == 4 ? 81 : (NTUPLE_LENGTH == 5 ? 243 : 729))),
+    NTUPLE_WEIGHT_COUNT = NTUPLE_COUNT * NTUPLE_TABLE_SIZE,
+    // the zero weight of the padding indices, and one more so a 32-bit gather at the last weight stays in bounds
+    NTUPLE_WEIGHT_PADDING = 2,
+    NTUPLE_WEIGHT_ONE     = 1 << 12, // a won position sums to about this
+    NTUPLE_SCORE_SCALE    = SCORE_HEURISTIC_MAX / 2 / NTUPLE_WEIGHT_ONE,
+    CELL_NTUPLE_MAX       = 6 * NTUPLE_LENGTH,
+};
+
+_Static_assert(BOARD_WIN_LENGTH >= 2 && BOARD_WIN_LENGTH <= BOARD_WIDTH, "BOARD_WIN_LENGTH must fit on the board");
+
+typedef enum eBoardTile {
+    BoardTile_PlayerTwo   = -1,
+    BoardTile_PlayerEmpty = 0,
+    BoardTile_PlayerOne   = 1,
+} BoardTile;
+
+static int                winConditions[WIN_CONDITION_COUNT][BOARD_WIN_LENGTH];
+static int                cellWinConditions[BOARD_SIZE][CELL_WIN_CONDITION_MAX];
+static int                cellWinConditionCounts[BOARD_SIZE];
+static unsigned long long analysisTileWeights[BOARD_SIZE];
+static unsigned long long proofTileKeys[2][BOARD_SIZE];
+static unsigned long long proofSideKey;
+static unsigned long long proofAttackerKey;
+static int                ntupleCellTuples[BOARD_SIZE][CELL_NTUPLE_MAX];
+static int                ntupleCellPowers[BOARD_SIZE][CELL_NTUPLE_MAX];
+static int                ntupleCellTupleCounts[BOARD_SIZE];
+
+// splitmix64: the next well-mixed 64-bit value from `seed`, for Zobrist keys and the tools' random numbers.
+static inline unsigned long long GetNextRandomKey(unsigned long long* seed) {
+    unsigned long long z = (*seed += 0x9E3779B97F4A7C15ULL);
+    z                    = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z                    = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline void AddNTupleCell(int tuple, int position, int cell) {
+    int power = 1;
+    for (int k = 0; k < position; ++k) {
+        power *= 3;
+    }
+    ntupleCellTuples[cell][ntupleCellTupleCounts[cell]] = tuple;
+    ntupleCellPowers[cell][ntupleCellTupleCounts[cell]] = power;
+    ntupleCellTupleCounts[cell]++;
+}
+
+// Builds the win lines (rows, columns, then both diagonals), the lines through each tile, the analysis and proof keys
+// and the N-tuples through each tile.
+// Must run once before any other engine function, and before spawning threads that use the engine.
+static inline void Engine_Initialize() {
+    static int const directions[4][2] = { { 0, 1 }, { 1, 0 }, { 1, 1 }, { 1, -1 } };
+
+    int count = 0;
+    for (int d = 0; d < 4; ++d) {
+        for (int row = 0; row < BOARD_WIDTH; ++row) {
+            for (int col = 0; col < BOARD_WIDTH; ++col) {
+                int const lastRow = row + directions[d][0] * (BOARD_WIN_LENGTH - 1);
+                int const lastCol = col + directions[d][1] * (BOARD_WIN_LENGTH - 1);
+                if (lastRow < 0 || lastRow >= BOARD_WIDTH || lastCol < 0 || lastCol >= BOARD_WIDTH) { continue; }
+                for (int k = 0; k < BOARD_WIN_LENGTH; ++k) {
+                    int const cell          = (row + directions[d][0] * k) * BOARD_WIDTH + col + directions[d][1] * k;
+                    winConditions[count][k] = cell;
+
+                    cellWinConditions[cell][cellWinConditionCounts[cell]++] = count;
+                }
+                count++;
+            }
+        }
+    }
+
+    analysisTileWeights[0] = 1;
+    for (int i = 1; i < BOARD_SIZE; ++i) {
+        analysisTileWeights[i] = analysisTileWeights[i - 1] * 3;
+    }
+
+    unsigned long long seed = 0x2545F4914F6CDD1DULL;
+    for (int side = 0; side < 2; ++side) {
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            proofTileKeys[side][i] = GetNextRandomKey(&seed);
+        }
+    }
+    proofSideKey     = GetNextRandomKey(&seed);
+    proofAttackerKey = GetNextRandomKey(&seed);
+
+    // straight runs in the win line order, then two-row blocks lying along rows and along columns
+    int tupleCount = 0;
+    for (int d = 0; d < 4; ++d) {
+        for (int row = 0; row < BOARD_WIDTH; ++row) {
+            for (int col = 0; col < BOARD_WIDTH; ++col) {
+                int const lastRow = row + directions[d][0] * (NTUPLE_LENGTH - 1);
+                int const lastCol = col + directions[d][1] * (NTUPLE_LENGTH - 1);
+                if (lastRow < 0 || lastRow >= BOARD_WIDTH || lastCol < 0 || lastCol >= BOARD_WIDTH) { continue; }
+                for (int k = 0; k < NTUPLE_LENGTH; ++k) {
+                    AddNTupleCell(tupleCount, k, (row + directions[d][0] * k) * BOARD_WIDTH + col + directions[d][1] * k);
+                }
+                tupleCount++;
+            }
+        }
+    }
+    for (int isAlongColumns = 0; isAlongColumns < 2; ++isAlongColumns) {
+        for (int across = 0; across < BOARD_WIDTH - 1; ++across) {
+            for (int along = 0; along <= BOARD_WIDTH - NTUPLE_BLOCK_LENGTH; ++along) {
+                for (int k = 0; k < NTUPLE_LENGTH; ++k) {
+                    int const row = across + k / NTUPLE_BLOCK_LENGTH;
+                    int const col = along + k % NTUPLE_BLOCK_LENGTH;
+                    AddNTupleCell(tupleCount, k, isAlongColumns ? col * BOARD_WIDTH + row : row * BOARD_WIDTH + col);
+                }
+                tupleCount++;
+            }
+        }
+    }
+}
+
+static inline int SatisfiesWinCondition(const BoardTile* board, const int* winCondition, BoardTile player) {
+    for (int k = 0; k < BOARD_WIN_LENGTH; ++k) {
+        if (board[winCondition[k]] != player) { return false; }
+    }
+    return true;
+}
+
+static inline int HasPlayerWonGame(const BoardTile* board, BoardTile player) {
+    for (int i = 0; i < WIN_CONDITION_COUNT; ++i) {
+        if (SatisfiesWinCondition(board, winConditions[i], player)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool IsBoardFull(const BoardTile* board) {
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (board[i] == BoardTile_PlayerEmpty) { return false; }
+    }
+    return true;
+}
+
+static inline int Evaluate(const BoardTile* board, BoardTile player, BoardTile opponent) {
+    if (HasPlayerWonGame(board, player)) { return 1; }
+    if (HasPlayerWonGame(board, opponent)) { return -1; }
+    if (IsBoardFull(board)) { return 0; }
+    return -2; // game is not over yet
+}
+
+// Plain minimax scored from `player`'s point of view. This is the reference every other engine is checked
+// against (see tools/enumerate_positions.c), so keep it free of pruning and caching.
+static inline int MinimaxRecursive(BoardTile* board, BoardTile player, BoardTile opponent, int depth, bool maximizingPlayer) { // NOLINT
+    int score = Evaluate(board, player, opponent);
+    if (score != -2 || depth == 0) { return score; }
+
+    int bestValue = 0;
+    if (maximizingPlayer) {
+        bestValue = INT_MIN;
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            if (board[i] == BoardTile_PlayerEmpty) {
+                board[i]  = player;
+                int value = MinimaxRecursive(board, player, opponent, depth - 1, false);
+                board[i]  = BoardTile_PlayerEmpty;
+                bestValue = max(bestValue, value);
+            }
+        }
+    } else {
+        bestValue = INT_MAX;
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            if (board[i] == BoardTile_PlayerEmpty) {
+                board[i]  = opponent;
+                int value = MinimaxRecursive(board, player, opponent, depth - 1, true);
+                board[i]  = BoardTile_PlayerEmpty;
+                bestValue = min(bestValue, value);
+            }
+        }
+    }
+
+    return bestValue;
+}
+
+// #region NTuple_Evaluation
+// A learned evaluation (see tools/ntuple_train.c): the sum of one weight per tuple, chosen by the tiles under it.
+// The weight offsets are kept per side, reading that side's tiles as 1 and the opponent's as 2, so the same
+// weights score the position for whichever side is to move.
+typedef struct NTupleState {
+    int offsets[2][NTUPLE_INDEX_COUNT];
+} NTupleState;
+
+static inline void NTuple_Initialize(NTupleState* state) {
+    for (int side = 0; side < 2; ++side) {
+        for (int t = 0; t < NTUPLE_INDEX_COUNT; ++t) {
+            state->offsets[side][t] = t < NTUPLE_COUNT ? t * NTUPLE_TABLE_SIZE : NTUPLE_WEIGHT_COUNT;
+        }
+    }
+}
+
+static inline void NTuple_Update(NTupleState* state, int cell, BoardTile tile, bool isPlaced) {
+    int const side = tile == BoardTile_PlayerOne ? 0 : 1;
+    int const sign = isPlaced ? 1 : -1;
+    for (int i = 0; i < ntupleCellTupleCounts[cell]; ++i) {
+        int const tuple = ntupleCellTuples[cell][i];
+        int const power = ntupleCellPowers[cell][i];
+        state->offsets[side][tuple] += sign * power;
+        state->offsets[1 - side][tuple] += sign * 2 * power;
+    }
+}
+
+// Returns the value of the position for `side` to move, in units of NTUPLE_WEIGHT_ONE. `weights` holds
+// NTUPLE_WEIGHT_COUNT weights followed by NTUPLE_WEIGHT_PADDING zeros (see ntuple.h).
+static inline int NTuple_Evaluate(const short* weights, const NTupleState* state, int side) {
+    int const* offsets = state->offsets[side];
+#if defined(__AVX2__)
+    // gathers 32 bits at each weight and keeps the sign-extended low half
+    __m256i sum = _mm256_setzero_si256();
+    for (int t = 0; t < NTUPLE_INDEX_COUNT; t += 8) {
+        __m256i const pairs = _mm256_i32gather_epi32((const int*)weights, _mm256_loadu_si256((const __m256i*)(offsets + t)), 2);
+        sum                 = _mm256_add_epi32(sum, _mm256_srai_epi32(_mm256_slli_epi32(pairs, 16), 16));
+    }
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    total         = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(1, 0, 3, 2)));
+    total         = _mm_add_epi32(total, _mm_shuffle_epi32(total, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(total);
+#elif defined(__SSE2__) || defined(_M_X64)
+    // there is no gather before AVX2; look the weights up one by one and sum them eight at a time
+    short gathered[NTUPLE_INDEX_COUNT];
+    for (int t = 0; t < NTUPLE_INDEX_COUNT; ++t) {
+        gathered[t] = weights[offsets[t]];
+    }
+    __m128i const ones = _mm_set1_epi16(1);
+    __m128i       sum  = _mm_setzero_si128();
+    for (int t = 0; t < NTUPLE_INDEX_COUNT; t += 8) {
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)(gathered + t)), ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+#else
+    int sum = 0;
+    for (int t = 0; t < NTUPLE_INDEX_COUNT; ++t) {
+        sum += weights[offsets[t]];
+    }
+    return sum;
+#endif
+}
+// #endregion // NTuple_Evaluation
+
+// #region Heuristic_Search
+// Static evaluation for depth-limited search, kept up to date tile by tile instead of rescanning the board at leaves.
+// Each line still open to exactly one player is worth GetHeuristicLineWeight(tiles in it) = 1 << 3 * (tiles - 1),
+// i.e. 1, 8, 64, ..., so one more tile outweighs up to seven lines with one fewer. Lines one tile short of complete
+// are also tracked as threats by the empty tile that would complete them. Having a threat on your move, or facing
+// threats on two different tiles, is a proven result and scored as such.
+typedef struct HeuristicState {
+    BoardTile     board[BOARD_SIZE];
+    unsigned char lineCounts[WIN_CONDITION_COUNT][2];
+    unsigned char threatLineCounts[2][BOARD_SIZE];
+    int           threatTileCounts[2];
+    int           completeLineCounts[2];
+    int           score; // PlayerOne's point of view
+    int           emptyCount;
+    const short*  network; // scores the leaves instead of the line weights unless NULL
+    NTupleState   tuples;  // only kept up to date with a network
+} HeuristicState;
+
+static inline int GetHeuristicSide(BoardTile player) { return player == BoardTile_PlayerOne ? 0 : 1; }
+
+static inline int GetHeuristicLineWeight(int count) { return count < 1 ? 0 : 1 << (3 * (count - 1)); }
+
+static inline void Heuristic_AddLine(HeuristicState* state, int line, int sign) {
+    unsigned char const* counts = state->lineCounts[line];
+    if (counts[0] && counts[1]) { return; }
+
+    for (int side = 0; side < 2; ++side) {
+        if (counts[1 - side]) { continue; }
+        if (counts[side] == BOARD_WIN_LENGTH) { state->completeLineCounts[side] += sign; }
+        if (counts[side] != BOARD_WIN_LENGTH - 1) { continue; }
+        for (int k = 0; k < BOARD_WIN_LENGTH; ++k) {
+            int const cell = winConditions[line][k];
+            if (state->board[cell] != BoardTile_PlayerEmpty) { continue; }
+            if (sign > 0 ? state->threatLineCounts[side][cell]++ == 0 : --state->threatLineCounts[side][cell] == 0) {
+                state->threatTileCounts[side] += sign;
+            }
+        }
+    }
+    state->score += sign * (GetHeuristicLineWeight(counts[0]) - GetHeuristicLineWeight(counts[1]));
+}
+
+// Sets `cell` to `tile` (or back to empty from `tile` when `isPlaced` is false), updating only the lines through it.
+static inline void Heuristic_Update(HeuristicState* state, int cell, BoardTile tile, bool isPlaced) {
+    int const side = GetHeuristicSide(tile);
+    for (int i = 0; i < cellWinConditionCounts[cell]; ++i) {
+        Heuristic_AddLine(state, cellWinConditions[cell][i], -1);
+    }
+    state->board[cell] = isPlaced ? tile : BoardTile_PlayerEmpty;
+    state->emptyCount += isPlaced ? -1 : 1;
+    if (state->network) { NTuple_Update(&state->tuples, cell, tile, isPlaced); }
+    for (int i = 0; i < cellWinConditionCounts[cell]; ++i) {
+        int const line = cellWinConditions[cell][i];
+        state->lineCounts[line][side] += isPlaced ? 1 : -1;
+        Heuristic_AddLine(state, line, 1);
+    }
+}
+
+static inline void Heuristic_Initialize(HeuristicState* state, const BoardTile* board, const short* network) {
+    memset(state, 0, sizeof(*state));
+    state->emptyCount = BOARD_SIZE;
+    state->network    = network;
+    if (network) { NTuple_Initialize(&state->tuples); }
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        state->board[i] = BoardTile_PlayerEmpty;
+    }
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (board[i] != BoardTile_PlayerEmpty) { Heuristic_Update(state, i, board[i], true); }
+    }
+}
+
+// Scores the position for `player` to move, `ply` moves below the root.
+static inline int Heuristic_Evaluate(const HeuristicState* state, BoardTile player, int ply) {
+    int const side = GetHeuristicSide(player);
+    if (state->threatTileCounts[side]) { return SCORE_WIN - ply - 1; }
+    if (state->threatTileCounts[1 - side] >= 2) { return -(SCORE_WIN - ply - 2); }
+
+    int const score = state->network ? NTuple_Evaluate(state->network, &state->tuples, side) * NTUPLE_SCORE_SCALE : (player == BoardTile_PlayerOne ? state->score : -state->score);
+    return max(-SCORE_HEURISTIC_MAX, min(SCORE_HEURISTIC_MAX, score));
+}
+
+static inline int HeuristicNegamax(HeuristicState* state, BoardTile player, BoardTile opponent, int depth, int alpha, int beta, int ply) { // NOLINT
+    int const side = GetHeuristicSide(player);
+    if (state->completeLineCounts[1 - side]) { return -(SCORE_WIN - ply); }
+    if (state->emptyCount < 1) { return 0; }
+    if (depth <= 0 || state->threatTileCounts[side] || state->threatTileCounts[1 - side] >= 2) {
+        return Heuristic_Evaluate(state, player, ply);
+    }
+
+    int bestValue = -SCORE_INFINITY;
+    for (int i = 0; i < BOARD_SIZE && alpha < beta; ++i) {
+        if (state->board[i] != BoardTile_PlayerEmpty) { continue; }
+        // a single opponent threat must be blocked; every other tile loses at once
+        if (state->threatTileCounts[1 - side] && !state->threatLineCounts[1 - side][i]) { continue; }
+        Heuristic_Update(state, i, player, true);
+        int value = -HeuristicNegamax(state, opponent, player, depth - 1, -beta, -alpha, ply + 1);
+        Heuristic_Update(state, i, player, false);
+        bestValue = max(bestValue, value);
+        alpha     = max(alpha, value);
+    }
+    return bestValue;
+}
+// #endregion // Heuristic_Search
+
+// Searches every root move (or only those set in `rootMoves` unless it is NULL) `depth` plies deep
+// and returns the first best one, writing its score to `value`. Leaves are scored with the N-tuple `network`
+// unless it is NULL, and with the line weights otherwise.
+static inline int GetHeuristicMove(const short* network, const BoardTile* board, BoardTile player, BoardTile opponent, int depth, const bool* rootMoves, int* value) {
+    HeuristicState state;
+    Heuristic_Initialize(&state, board, network);
+
+    int bestMove  = -1;
+    int bestValue = -SCORE_INFINITY;
+    for (int i = 0; i < BOARD_SIZE; i++) {
+        if (state.board[i] == BoardTile_PlayerEmpty && (!rootMoves || rootMoves[i])) {
+            TRACE_SCOPE_ARG("GetAIMove root move", i) {
+                Heuristic_Update(&state, i, player, true);
+                int currentValue = -HeuristicNegamax(&state, opponent, player, depth, -SCORE_INFINITY, -bestValue, 1);
+                Heuristic_Update(&state, i, player, false);
+                if (currentValue > bestValue || bestMove < 0) {
+                    bestValue = currentValue;
+                    bestMove  = i;
+                }
+            }
+        }
+    }
+    *value = bestValue;
+    return bestMove;
+}
+
+// #region Proof_Number_Search
+// Depth-first proof-number search (df-pn) for a forced win by continuous threats. The attacker only plays tiles
+// that leave a line one tile short of complete (or blocks the defender's threat) and the defender only blocks,
+// so a proof is a real forced win, while a disproof only means that no such threat sequence exists.
+// Proof and disproof numbers are kept from the side to move's point of view (phi, delta) in a fixed-size
+// always-replace table, so memory stays bounded however long a proof runs.
+typedef enum eProofResult {
+    ProofResult_Unknown = 0,
+    ProofResult_Proven,
+    ProofResult_Disproven
+} ProofResult;
+
+typedef struct ProofEntry {
+    unsigned long long key;
+    unsigned int       phi;
+    unsigned int       delta;
+} ProofEntry;
+
+// One cache per thread; entries are not written atomically.
+typedef struct ProofCache {
+    ProofEntry entries[PROOF_CACHE_SIZE];
+} ProofCache;
+
+typedef struct ProofSearch {
+    ProofCache*        cache;
+    HeuristicState     state;
+    unsigned long long key;
+    long long          nodeCount;
+    long long          nodeLimit;
+    int                attacker;
+} ProofSearch;
+
+static ProofCache proofCache;
+
+static inline void Proof_Lookup(const ProofSearch* search, unsigned long long key, unsigned int* phi, unsigned int* delta) {
+    ProofEntry const* entry = &search->cache->entries[key & (PROOF_CACHE_SIZE - 1)];
+    *phi                    = entry->key == key ? entry->phi : 1;
+    *delta                  = entry->key == key ? entry->delta : 1;
+}
+
+static inline void Proof_Store(ProofSearch* search, unsigned long long key, unsigned int phi, unsigned int delta) {
+    ProofEntry* entry = &search->cache->entries[key & (PROOF_CACHE_SIZE - 1)];
+    entry->key        = key;
+    entry->phi        = phi;
+    entry->delta      = delta;
+}
+
+// Fills `moves` for `side` to move and returns their count, or returns -1 when `side` has already succeeded
+// (the attacker can complete a line, or the defender has escaped) and 0 when it has failed.
+static inline int Proof_GetMoves(const ProofSearch* search, int side, int* moves) {
+    HeuristicState const* state    = &search->state;
+    int const             attacker = search->attacker;
+    int const             defender = 1 - attacker;
+    int                   count    = 0;
+
+    if (side == attacker) {
+        if (state->threatTileCounts[attacker]) { return -1; }
+        if (state->threatTileCounts[defender] >= 2 || state->emptyCount < 1) { return 0; }
+    } else {
+        if (state->threatTileCounts[defender] || !state->threatTileCounts[attacker] || state->emptyCount < 1) { return -1; }
+        if (state->threatTileCounts[attacker] >= 2) { return 0; }
+    }
+
+    int const threatSide = side == attacker ? defender : attacker;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (state->board[i] != BoardTile_PlayerEmpty) { continue; }
+        if (state->threatTileCounts[threatSide]) {
+            if (state->threatLineCounts[threatSide][i]) { moves[count++] = i; }
+            continue;
+        }
+        for (int j = 0; j < cellWinConditionCounts[i]; ++j) {
+            unsigned char const* counts = state->lineCounts[cellWinConditions[i][j]];
+            if (counts[attacker] == BOARD_WIN_LENGTH - 2 && !counts[defender]) {
+                moves[count++] = i;
+                break;
+            }
+        }
+    }
+    return count;
+}
+
+static inline void ProofSearchRecursive(ProofSearch* search, int side, unsigned int thresholdPhi, unsigned int thresholdDelta) { // NOLINT
+    unsigned long long const key = search->key;
+
+    int       moves[BOARD_SIZE];
+    int const moveCount = Proof_GetMoves(search, side, moves);
+    if (moveCount <= 0) {
+        Proof_Store(search, key, moveCount < 0 ? 0 : PROOF_INFINITY, moveCount < 0 ? PROOF_INFINITY : 0);
+        return;
+    }
+
+    BoardTile const tile = side == 0 ? BoardTile_PlayerOne : BoardTile_PlayerTwo;
+    for (;;) {
+        // phi is the smallest child delta and delta the sum of the child phis
+        unsigned int phi         = PROOF_INFINITY;
+        unsigned int delta       = 0;
+        unsigned int secondDelta = PROOF_INFINITY;
+        unsigned int bestPhi     = 0;
+        int          best        = 0;
+        for (int i = 0; i < moveCount; ++i) {
+            unsigned int childPhi   = 0;
+            unsigned int childDelta = 0;
+            Proof_Lookup(search, key ^ proofTileKeys[side][moves[i]] ^ proofSideKey, &childPhi, &childDelta);
+            if (childDelta < phi) {
+                secondDelta = phi;
+                phi         = childDelta;
+                bestPhi     = childPhi;
+                best        = i;
+            } else if (childDelta < secondDelta) {
+                secondDelta = childDelta;
+            }
+            delta = min(delta + childPhi, (unsigned int)PROOF_INFINITY);
+        }
+        if (phi >= thresholdPhi || delta >= thresholdDelta || search->nodeCount >= search->nodeLimit) {
+            Proof_Store(search, key, phi, delta);
+            return;
+        }
+
+        search->nodeCount++;
+        search->key = key ^ proofTileKeys[side][moves[best]] ^ proofSideKey;
+        Heuristic_Update(&search->state, moves[best], tile, true);
+        ProofSearchRecursive(search, 1 - side, thresholdDelta - delta + bestPhi, min(thresholdPhi, secondDelta + 1));
+        Heuristic_Update(&search->state, moves[best], tile, false);
+        search->key = key;
+    }
+}
+
+// Tries to prove that `player`, to move, wins by continuous threats within `nodeLimit` expansions.
+// When proven, `move` receives the first move of the threat sequence.
+static inline ProofResult ProveWin(ProofCache* cache, const BoardTile* board, BoardTile player, long long nodeLimit, int* move) {
+    ProofSearch search;
+    search.cache     = cache;
+    search.key       = 0;
+    search.nodeCount = 0;
+    search.nodeLimit = nodeLimit;
+    search.attacker  = GetHeuristicSide(player);
+    Heuristic_Initialize(&search.state, board, NULL);
+    if (search.state.completeLineCounts[0] || search.state.completeLineCounts[1]) { return ProofResult_Unknown; }
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (board[i] != BoardTile_PlayerEmpty) { search.key ^= proofTileKeys[GetHeuristicSide(board[i])][i]; }
+    }
+    search.key ^= search.attacker ? proofAttackerKey ^ proofSideKey : 0;
+
+    ProofSearchRecursive(&search, search.attacker, PROOF_INFINITY, PROOF_INFINITY);
+    unsigned int phi   = 0;
+    unsigned int delta = 0;
+    Proof_Lookup(&search, search.key, &phi, &delta);
+    if (delta == 0) { return ProofResult_Disproven; }
+    if (phi != 0) { return ProofResult_Unknown; }
+
+    // the winning move is a tile completing a line, or a child whose side to move is disproven
+    int       moves[BOARD_SIZE];
+    int const moveCount = Proof_GetMoves(&search, search.attacker, moves);
+    for (int i = 0; i < BOARD_SIZE && moveCount < 0; ++i) {
+        if (search.state.board[i] == BoardTile_PlayerEmpty && search.state.threatLineCounts[search.attacker][i]) {
+            *move = i;
+            return ProofResult_Proven;
+        }
+    }
+    for (int i = 0; i < moveCount; ++i) {
+        Proof_Lookup(&search, search.key ^ proofTileKeys[search.attacker][moves[i]] ^ proofSideKey, &phi, &delta);
+        if (delta == 0) {
+            *move = moves[i];
+            return ProofResult_Proven;
+        }
+    }
+    return ProofResult_Unknown; // the proof tree was overwritten in the table
+}
+// #endregion // Proof_Number_Search
+
+// Plays a proven threat-sequence win if there is one. Otherwise, if the opponent would have one were it their move,
+// the heuristic search only considers the tiles after which that win can no longer be proven, scoring its leaves
+// with `network` (or the line weights when it is NULL).
+static inline int GetProofMove(ProofCache* cache, const short* network, const BoardTile* board, BoardTile player, BoardTile opponent, int depth, int* value) {
+    int         move   = -1;
+    ProofResult result = ProofResult_Unknown;
+    TRACE_SCOPE("ProveWin") { result = ProveWin(cache, board, player, PROOF_NODE_LIMIT, &move); }
+    if (result == ProofResult_Proven) {
+        *value = SCORE_WIN - 1;
+        return move;
+    }
+
+    bool defenses[BOARD_SIZE] = { false };
+    int  defenseCount         = 0;
+    TRACE_SCOPE("ProveDefenses") {
+        if (ProveWin(cache, board, opponent, PROOF_NODE_LIMIT, &move) == ProofResult_Proven) {
+            BoardTile trial[BOARD_SIZE];
+            memcpy(trial, board, sizeof(trial));
+            for (int i = 0; i < BOARD_SIZE; ++i) {
+                if (trial[i] != BoardTile_PlayerEmpty) { continue; }
+                trial[i]    = player;
+                defenses[i] = ProveWin(cache, trial, opponent, PROOF_DEFENSE_NODE_LIMIT, &move) != ProofResult_Proven;
+                trial[i]    = BoardTile_PlayerEmpty;
+                defenseCount += defenses[i];
+            }
+        }
+    }
+    return GetHeuristicMove(network, board, player, opponent, depth, defenseCount ? defenses : NULL, value);
+}
+
+// Easy (difficulty 1) plays a random empty tile; otherwise `difficulty` is the search depth below each root move.
+static inline int GetAIMove(int difficulty, BoardTile* board, BoardTile player, BoardTile opponent) {
+    int aiMove = 0;
+
+    if (difficulty == 1) {
+        do {
+            aiMove = rand() % BOARD_SIZE; // NOLINT
+        } while (board[aiMove] != BoardTile_PlayerEmpty);
+        return aiMove;
+    }
+
+    int value = 0;
+    return GetProofMove(&proofCache, NULL, board, player, opponent, difficulty, &value);
+}
+
+// #region Move_Analysis
+// Scores every empty tile in one pass. Positions are keyed by their base-3 encoding plus the side to move
+// (exact up to 40 tiles; on larger boards the key wraps around and acts as a hash),
+// so transpositions reached through different tiles (and later positions while exploring with undo/redo)
+// share a single cache instead of being searched again per tile.
+typedef struct AnalysisEntry {
+    unsigned long long key;
+    signed char        value;
+    unsigned char      bound; // SearchBound
+} AnalysisEntry;
+
+// One cache per thread; entries are not written atomically.
+typedef struct AnalysisCache {
+    AnalysisEntry entries[ANALYSIS_CACHE_SIZE];
+} AnalysisCache;
+
+static inline unsigned long long GetAnalysisTileCode(BoardTile tile) {
+    return tile == BoardTile_PlayerOne ? 1 : (tile == BoardTile_PlayerTwo ? 2 : 0);
+}
+
+static inline unsigned long long GetAnalysisCode(const BoardTile* board) {
+    unsigned long long code = 0;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        code += GetAnalysisTileCode(board[i]) * analysisTileWeights[i];
+    }
+    return code;
+}
+
+static inline int AnalyzeNegamax(AnalysisCache* cache, BoardTile* board, BoardTile player, BoardTile opponent, unsigned long long code, int emptyCount, int alpha, int beta) { // NOLINT
+    if (HasPlayerWonGame(board, opponent)) { return -1; }
+    if (emptyCount < 1) { return 0; }
+
+    unsigned long long const key   = (code << 1 | (player == BoardTile_PlayerOne)) + 1;
+    AnalysisEntry* const     entry = &cache->entries[key & (ANALYSIS_CACHE_SIZE - 1)];
+    if (entry->key == key) {
+        if (Search_ApplyBound((SearchBound)entry->bound, entry->value, &alpha, &beta)) { return entry->value; }
+    }
+
+    int const alphaOrigin = alpha;
+    int       bestValue   = -1;
+    for (int i = 0; i < BOARD_SIZE && alpha < beta; ++i) {
+        if (board[i] != BoardTile_PlayerEmpty) { continue; }
+        board[i]  = player;
+        int value = -AnalyzeNegamax(cache, board, opponent, player, code + GetAnalysisTileCode(player) * analysisTileWeights[i], emptyCount - 1, -beta, -alpha);
+        board[i]  = BoardTile_PlayerEmpty;
+        bestValue = max(bestValue, value);
+        alpha     = max(alpha, value);
+    }
+
+    entry->key   = key;
+    entry->value = (signed char)bestValue;
+    entry->bound = (unsigned char)Search_GetBound(bestValue, alphaOrigin, beta);
+    return bestValue;
+}
+
+// Writes each empty tile's minimax value for `player` to move (1 win, 0 draw, -1 loss) into `scores`,
+// and ANALYSIS_SCORE_NONE for occupied tiles or when the game is already decided.
+static inline void AnalyzeMoves(AnalysisCache* cache, const BoardTile* board, BoardTile player, BoardTile opponent, int* scores) {
+    BoardTile work[BOARD_SIZE];
+    int       emptyCount = 0;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        work[i]   = board[i];
+        scores[i] = ANALYSIS_SCORE_NONE;
+        emptyCount += board[i] == BoardTile_PlayerEmpty;
+    }
+    if (HasPlayerWonGame(work, player) || HasPlayerWonGame(work, opponent)) { return; }
+
+    unsigned long long const code = GetAnalysisCode(work);
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (work[i] != BoardTile_PlayerEmpty) { continue; }
+        work[i]   = player;
+        scores[i] = -AnalyzeNegamax(cache, work, opponent, player, code + GetAnalysisTileCode(player) * analysisTileWeights[i], emptyCount - 1, -1, 1);
+        work[i]   = BoardTile_PlayerEmpty;
+    }
+}
+// #endregion // Move_Analysis
+
+#endif // TIC_TAC_TOE_ENGINE_H
@@ -0,0 +1,154 @@
+/**
+ * @file headless.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Scripted key input, output redirected to the null device and per-scene frame timing for unattended runs
+    of the scene loop. Each byte of the script is the key read by one frame; '.' is a frame without a key, '~' is
+    Enter and line breaks are skipped.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_HEADLESS_H
+#define TIC_TAC_TOE_HEADLESS_H
+
+// #region Header_Inclusion
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+// #endregion // Header_Inclusion
+
+#if defined(_WIN32)
+#define HEADLESS_NULL_DEVICE "NUL"
+#else
+#define HEADLESS_NULL_DEVICE "/dev/null"
+#endif
+
+enum {
+    HEADLESS_SCENE_COUNT_MAX = 8,
+    HEADLESS_IDLE_KEY        = '.',
+    HEADLESS_ENTER_KEY       = '~',
+    HEADLESS_KEY_NONE        = -1,
+    HEADLESS_KEY_ENTER       = '\r',
+    HEADLESS_OUTPUT_BUFFER   = 1 << 16,
+};
+
+typedef enum eHeadlessPhase {
+    HeadlessPhase_ProcessInput = 0,
+    HeadlessPhase_Update,
+    HeadlessPhase_Draw,
+    HeadlessPhase_Count
+} HeadlessPhase;
+
+typedef struct HeadlessSceneTimes {
+    const char* name;
+    long long   frameCount;
+    long long   phaseNS[HeadlessPhase_Count];
+} HeadlessSceneTimes;
+
+// Started at the top of a frame; every phase is charged to the scene that was current then.
+typedef struct HeadlessFrame {
+    HeadlessSceneTimes* scene;
+    long long           lapNS;
+} HeadlessFrame;
+
+static FILE*              headlessScript;
+static bool               headlessIsScriptDone;
+static long long          headlessStartNS;
+static int                headlessSceneCount;
+static HeadlessSceneTimes headlessScenes[HEADLESS_SCENE_COUNT_MAX];
+
+static inline long long Headless_GetTimeNS() {
+    struct timespec now;
+    (void)timespec_get(&now, TIME_UTC);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Replaces keyboard input with the bytes of `path`. Frames are only timed while a script is open.
+static inline bool Headless_OpenScript(const char* path) {
+    headlessScript = fopen(path, "rb");
+    if (!headlessScript) { return false; }
+    headlessIsScriptDone = false;
+    headlessStartNS      = Headless_GetTimeNS();
+    return true;
+}
+
+// Redirects stdout to the null device. Scenes still draw every frame; only the terminal output is dropped.
+static inline bool Headless_OpenNullOutput() {
+    if (!freopen(HEADLESS_NULL_DEVICE, "w", stdout)) { return false; }
+    (void)setvbuf(stdout, NULL, _IOFBF, HEADLESS_OUTPUT_BUFFER);
+    return true;
+}
+
+static inline bool Headless_IsScripted() { return headlessScript != NULL; }
+
+static inline bool Headless_IsScriptDone() { return headlessIsScriptDone; }
+
+// Returns the next scripted key, HEADLESS_KEY_NONE for an idle frame, or HEADLESS_KEY_NONE and marks the script done at its end.
+// Line breaks in the script only lay it out, so Enter is written as HEADLESS_ENTER_KEY.
+static inline int Headless_GetKey() {
+    int key = 0;
+    do {
+        key = fgetc(headlessScript);
+    } while (key == '\n' || key == '\r');
+    if (key == EOF) {
+        headlessIsScriptDone = true;
+        return HEADLESS_KEY_NONE;
+    }
+    if (key == HEADLESS_ENTER_KEY) { return HEADLESS_KEY_ENTER; }
+    return key == HEADLESS_IDLE_KEY ? HEADLESS_KEY_NONE : key;
+}
+
+static inline HeadlessFrame Headless_BeginFrame(const char* sceneName) {
+    HeadlessFrame frame = { NULL, 0 };
+    if (!headlessScript) { return frame; }
+
+    for (int i = 0; i < headlessSceneCount && !frame.scene; ++i) {
+        if (strcmp(headlessScenes[i].name, sceneName) == 0) { frame.scene = &headlessScenes[i]; }
+    }
+    if (!frame.scene) {
+        if (headlessSceneCount == HEADLESS_SCENE_COUNT_MAX) { return frame; }
+        frame.scene       = &headlessScenes[headlessSceneCount++];
+        frame.scene->name = sceneName;
+    }
+    ++frame.scene->frameCount;
+    frame.lapNS = Headless_GetTimeNS();
+    return frame;
+}
+
+static inline void Headless_EndPhase(HeadlessFrame* frame, HeadlessPhase phase) {
+    if (!frame->scene) { return; }
+    long long const nowNS = Headless_GetTimeNS();
+    frame->scene->phaseNS[phase] += nowNS - frame->lapNS;
+    frame->lapNS = nowNS;
+}
+
+// Closes the script and prints the frame rate and the time spent in each scene to `stream`.
+static inline void Headless_Report(FILE* stream) {
+    if (!headlessScript) { return; }
+    (void)fclose(headlessScript);
+    headlessScript = NULL;
+
+    double const elapsedMS  = (double)(Headless_GetTimeNS() - headlessStartNS) / 1e6;
+    long long    frameCount = 0;
+    for (int i = 0; i < headlessSceneCount; ++i) {
+        frameCount += headlessScenes[i].frameCount;
+    }
+    (void)fprintf(stream, "%lld frames in %.1f ms (%.0f frames/s)\n", frameCount, elapsedMS, elapsedMS > 0 ? (double)frameCount * 1000.0 / elapsedMS : 0.0);
+    (void)fprintf(stream, "%-8s %10s %12s %12s %12s %12s %12s\n", "scene", "frames", "input ms", "update ms", "draw ms", "total ms", "us/frame");
+    for (int i = 0; i < headlessSceneCount; ++i) {
+        HeadlessSceneTimes const* scene   = &headlessScenes[i];
+        long long                 totalNS = 0;
+        for (int phase = 0; phase < HeadlessPhase_Count; ++phase) {
+            totalNS += scene->phaseNS[phase];
+        }
+        (void)fprintf(stream, "%-8s %10lld %12.3f %12.3f %12.3f %12.3f %12.2f\n", scene->name, scene->frameCount, (double)scene->phaseNS[HeadlessPhase_ProcessInput] / 1e6, (double)scene->phaseNS[HeadlessPhase_Update] / 1e6, (double)scene->phaseNS[HeadlessPhase_Draw] / 1e6, (double)totalNS / 1e6, scene->frameCount > 0 ? (double)totalNS / 1e3 / (double)scene->frameCount : 0.0);
+    }
+}
+
+#endif // TIC_TAC_TOE_HEADLESS_H
@@ -0,0 +1,119 @@
+/**
+ * @file mapped_file.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Fixed-size files mapped into memory and shared between processes.
+    Uses CreateFileMapping on Windows and mmap elsewhere.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_MAPPED_FILE_H
+#define TIC_TAC_TOE_MAPPED_FILE_H
+
+// #region Header_Inclusion
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+// #endregion // Header_Inclusion
+
+enum {
+    MAPPED_FILE_HEAD_SIZE = 64,
+};
+
+typedef enum eMappedFileMode {
+    MappedFile_ReadOnly = 0, // existing file, read-only view
+    MappedFile_Shared        // created if missing; a shorter file the check accepts is extended with zeros to the size
+} MappedFileMode;
+
+// Decides from the file's current `length` and its first MAPPED_FILE_HEAD_SIZE bytes (zero past the end of
+// the file) whether it may be mapped, before anything is written to it.
+typedef bool (*MappedFileCheck)(const void* head, unsigned long long length);
+
+typedef struct MappedFile {
+    void*  view;
+    size_t size;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} MappedFile;
+
+// Maps the first `size` bytes of `path` and returns the view, or NULL on failure or when `check` (unless NULL)
+// rejects the file, which is then left as it was.
+static inline void* MappedFile_Open(MappedFile* mapped, const char* path, size_t size, MappedFileMode mode, MappedFileCheck check) {
+    bool const    isWritable                  = mode != MappedFile_ReadOnly;
+    unsigned char head[MAPPED_FILE_HEAD_SIZE] = { 0 };
+    mapped->view                              = NULL;
+    mapped->size                              = size;
+#if defined(_WIN32)
+    DWORD const creation = isWritable ? OPEN_ALWAYS : OPEN_EXISTING;
+    mapped->file         = CreateFileA(path, isWritable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, creation, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapped->file == INVALID_HANDLE_VALUE) { return NULL; }
+    LARGE_INTEGER length;
+    DWORD         headRead = 0;
+    if (!GetFileSizeEx(mapped->file, &length) || (!isWritable && (unsigned long long)length.QuadPart < size)
+        || (check && (!ReadFile(mapped->file, head, sizeof(head), &headRead, NULL) || !check(head, (unsigned long long)length.QuadPart)))) {
+        CloseHandle(mapped->file);
+        return NULL;
+    }
+    // a writable mapping larger than the file extends it with zeros
+    mapped->mapping = CreateFileMappingA(mapped->file, NULL, isWritable ? PAGE_READWRITE : PAGE_READONLY, 0, (DWORD)size, NULL);
+    if (!mapped->mapping) {
+        CloseHandle(mapped->file);
+        return NULL;
+    }
+    mapped->view = MapViewOfFile(mapped->mapping, isWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+    if (!mapped->view) {
+        CloseHandle(mapped->mapping);
+        CloseHandle(mapped->file);
+        return NULL;
+    }
+#else
+    int const flags = isWritable ? O_RDWR | O_CREAT : O_RDONLY;
+    int const file  = open(path, flags, 0644);
+    if (file < 0) { return NULL; }
+    off_t const length = lseek(file, 0, SEEK_END);
+    if (length < 0 || (!isWritable && length < (off_t)size)
+        || (check && (lseek(file, 0, SEEK_SET) < 0 || read(file, head, sizeof(head)) < 0 || !check(head, (unsigned long long)length)))) {
+        close(file);
+        return NULL;
+    }
+    // grow a short file by writing its last byte, which needs nothing beyond the base POSIX headers
+    if (isWritable && length < (off_t)size && (lseek(file, (off_t)size - 1, SEEK_SET) < 0 || write(file, "", 1) != 1)) {
+        close(file);
+        return NULL;
+    }
+    void* view = mmap(NULL, size, isWritable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    mapped->view = view == MAP_FAILED ? NULL : view;
+#endif
+    return mapped->view;
+}
+
+static inline void MappedFile_Close(MappedFile* mapped) {
+    if (!mapped->view) { return; }
+#if defined(_WIN32)
+    UnmapViewOfFile(mapped->view);
+    CloseHandle(mapped->mapping);
+    CloseHandle(mapped->file);
+#else
+    munmap(mapped->view, mapped->size);
+#endif
+    mapped->view = NULL;
+}
+
+#endif // TIC_TAC_TOE_MAPPED_FILE_H
@@ -0,0 +1,82 @@
+/**
+ * @file ntuple.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief N-tuple network weight files, as written and read back by tools/ntuple_train.c; the game does not load them.
+    A short header identifies the board and tuple layout, followed by one 16-bit weight per tuple entry.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_NTUPLE_H
+#define TIC_TAC_TOE_NTUPLE_H
+
+// #region Header_Inclusion
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "engine.h"
+// #endregion // Header_Inclusion
+
+enum {
+    NTUPLE_MAGIC   = 0x4E545454, // "TTTN"
+    NTUPLE_VERSION = 1,
+};
+
+// Written in host byte order; a file from a host of the other byte order fails the magic check.
+typedef struct NTupleFileHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int boardWidth;
+    unsigned int winLength;
+    unsigned int tupleLength;
+    unsigned int tupleCount;
+} NTupleFileHeader;
+
+// Room for the network of this build's board, padding included, for programs that load a single one.
+// Searches use it only where it is passed to GetHeuristicMove() or GetProofMove().
+static short ntupleNetwork[NTUPLE_WEIGHT_COUNT + NTUPLE_WEIGHT_PADDING];
+
+static inline NTupleFileHeader NTuple_GetHeader() {
+    NTupleFileHeader const header = { NTUPLE_MAGIC, NTUPLE_VERSION, BOARD_WIDTH, BOARD_WIN_LENGTH, NTUPLE_LENGTH, NTUPLE_COUNT };
+    return header;
+}
+
+// Rounds a weight in won-game units to the fixed-point format, saturating at the 16-bit range.
+static inline short NTuple_Quantize(float weight) {
+    float const scaled = weight * (float)NTUPLE_WEIGHT_ONE;
+    return (short)(scaled >= 32767.0f ? 32767 : (scaled <= -32768.0f ? -32768 : (int)(scaled + (scaled < 0 ? -0.5f : 0.5f))));
+}
+
+// Reads the network of this build's board layout from `path` into `weights` (NTUPLE_WEIGHT_COUNT + NTUPLE_WEIGHT_PADDING entries).
+static inline bool NTuple_Load(const char* path, short* weights) {
+    FILE* file = fopen(path, "rb");
+    if (!file) { return false; }
+
+    NTupleFileHeader       header   = { 0 };
+    NTupleFileHeader const expected = NTuple_GetHeader();
+    bool const             isValid  = fread(&header, sizeof(header), 1, file) == 1 && memcmp(&header, &expected, sizeof(header)) == 0
+                         && fread(weights, sizeof(*weights), NTUPLE_WEIGHT_COUNT, file) == NTUPLE_WEIGHT_COUNT;
+    (void)fclose(file);
+    if (!isValid) { return false; }
+
+    for (int i = 0; i < NTUPLE_WEIGHT_PADDING; ++i) {
+        weights[NTUPLE_WEIGHT_COUNT + i] = 0;
+    }
+    return true;
+}
+
+static inline bool NTuple_Save(const char* path, const short* weights) {
+    FILE* file = fopen(path, "wb");
+    if (!file) { return false; }
+
+    NTupleFileHeader const header  = NTuple_GetHeader();
+    bool const             isSaved = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(weights, sizeof(*weights), NTUPLE_WEIGHT_COUNT, file) == NTUPLE_WEIGHT_COUNT;
+    return fclose(file) == 0 && isSaved;
+}
+
+#endif // TIC_TAC_TOE_NTUPLE_H
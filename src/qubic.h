@@ -0,0 +1,261 @@
+/**
+ * @file qubic.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Qubic (4x4x4 tic-tac-toe) engine on 64-bit bitboards.
+    Tile index is layer * 16 + row * 4 + column; any of the 76 straight lines of four wins.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_QUBIC_H
+#define TIC_TAC_TOE_QUBIC_H
+
+// #region Header_Inclusion
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "engine.h"
+#include "search.h"
+// #endregion // Header_Inclusion
+
+enum {
+    QUBIC_WIDTH          = 4,
+    QUBIC_LAYER_SIZE     = QUBIC_WIDTH * QUBIC_WIDTH,
+    QUBIC_SIZE           = QUBIC_LAYER_SIZE * QUBIC_WIDTH,
+    QUBIC_LINE_COUNT     = 76,
+    QUBIC_CELL_LINE_MAX  = 7,
+    QUBIC_DEPTH_MAX      = 32,
+    QUBIC_TIME_BUDGET_MS = 400,
+    QUBIC_CACHE_SIZE     = 1 << 18,
+};
+
+typedef unsigned long long QubicBits;
+
+static QubicBits     qubicLineMasks[QUBIC_LINE_COUNT];
+static unsigned char qubicCellLines[QUBIC_SIZE][QUBIC_CELL_LINE_MAX];
+static unsigned char qubicCellLineCount[QUBIC_SIZE];
+
+// Builds the 76 line masks and, per cell, the lines passing through it.
+static inline void Qubic_Initialize() {
+    int count = 0;
+    for (int dz = -1; dz <= 1; ++dz) {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                // keep one of each pair of opposite directions
+                int const leading = dz ? dz : (dy ? dy : dx);
+                if (leading <= 0) { continue; }
+                for (int z = 0; z < QUBIC_WIDTH; ++z) {
+                    for (int y = 0; y < QUBIC_WIDTH; ++y) {
+                        for (int x = 0; x < QUBIC_WIDTH; ++x) {
+                            int const lastZ = z + dz * (QUBIC_WIDTH - 1);
+                            int const lastY = y + dy * (QUBIC_WIDTH - 1);
+                            int const lastX = x + dx * (QUBIC_WIDTH - 1);
+                            if (lastZ < 0 || lastZ >= QUBIC_WIDTH || lastY < 0 || lastY >= QUBIC_WIDTH || lastX < 0 || lastX >= QUBIC_WIDTH) { continue; }
+
+                            QubicBits mask = 0;
+                            for (int k = 0; k < QUBIC_WIDTH; ++k) {
+                                int const cell = (z + dz * k) * QUBIC_LAYER_SIZE + (y + dy * k) * QUBIC_WIDTH + x + dx * k;
+                                mask |= 1ULL << cell;
+                                qubicCellLines[cell][qubicCellLineCount[cell]++] = (unsigned char)count;
+                            }
+                            qubicLineMasks[count++] = mask;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static inline int Qubic_CountBits(QubicBits bits) { return __builtin_popcountll(bits); }
+
+static inline bool Qubic_HasLine(QubicBits mine) {
+    for (int i = 0; i < QUBIC_LINE_COUNT; ++i) {
+        if ((mine & qubicLineMasks[i]) == qubicLineMasks[i]) { return true; }
+    }
+    return false;
+}
+
+// Empty cells that would complete one of `mine`'s lines.
+static inline QubicBits Qubic_GetThreats(QubicBits mine, QubicBits theirs) {
+    QubicBits threats = 0;
+    for (int i = 0; i < QUBIC_LINE_COUNT; ++i) {
+        QubicBits const line = qubicLineMasks[i];
+        if (!(line & theirs) && Qubic_CountBits(line & mine) == QUBIC_WIDTH - 1) {
+            threats |= line & ~mine;
+        }
+    }
+    return threats;
+}
+
+static inline void Qubic_ToBits(const BoardTile* board, BoardTile player, QubicBits* mine, QubicBits* theirs) {
+    *mine   = 0;
+    *theirs = 0;
+    for (int i = 0; i < QUBIC_SIZE; ++i) {
+        if (board[i] == player) {
+            *mine |= 1ULL << i;
+        } else if (board[i] != BoardTile_PlayerEmpty) {
+            *theirs |= 1ULL << i;
+        }
+    }
+}
+
+// Same contract as Evaluate(): 1 if `player` won, -1 if `opponent` won, 0 for a draw, -2 while undecided.
+static inline int Qubic_Evaluate(const BoardTile* board, BoardTile player, BoardTile opponent) {
+    (void)opponent;
+    QubicBits mine   = 0;
+    QubicBits theirs = 0;
+    Qubic_ToBits(board, player, &mine, &theirs);
+    if (Qubic_HasLine(mine)) { return 1; }
+    if (Qubic_HasLine(theirs)) { return -1; }
+    if ((mine | theirs) == ~0ULL) { return 0; }
+    return -2;
+}
+
+// #region Qubic_Search
+// Position of a root move search: the side to move's tiles and the opponent's.
+typedef struct QubicPosition {
+    QubicBits mine;
+    QubicBits theirs;
+} QubicPosition;
+
+static SearchCacheEntry qubicCache[QUBIC_CACHE_SIZE];
+
+static inline QubicBits Qubic_Hash(QubicBits mine, QubicBits theirs) {
+    QubicBits hash = mine * 0x9E3779B97F4A7C15ULL ^ (theirs + 0x632BE59BD9B4E019ULL) * 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 31;
+    return hash | 1;
+}
+
+// Open lines weighted by how many tiles they already hold, from the side to move's point of view.
+static inline int Qubic_EvaluateStatic(QubicBits mine, QubicBits theirs) {
+    static int const weights[QUBIC_WIDTH] = { 0, 1, 6, 40 };
+
+    int score = 0;
+    for (int i = 0; i < QUBIC_LINE_COUNT; ++i) {
+        QubicBits const line = qubicLineMasks[i];
+        if (!(line & theirs)) {
+            score += weights[Qubic_CountBits(line & mine)];
+        } else if (!(line & mine)) {
+            score -= weights[Qubic_CountBits(line & theirs)];
+        }
+    }
+    return score;
+}
+
+// Move ordering: cells that extend our open lines (and so build threats and forks) or cut the opponent's come first.
+static inline int Qubic_ScoreMove(QubicBits mine, QubicBits theirs, int cell) {
+    static int const extendWeights[QUBIC_WIDTH] = { 1, 4, 32, 1024 };
+    static int const blockWeights[QUBIC_WIDTH]  = { 0, 3, 24, 512 };
+
+    int score = 0;
+    for (int i = 0; i < qubicCellLineCount[cell]; ++i) {
+        QubicBits const line = qubicLineMasks[qubicCellLines[cell][i]];
+        if (!(line & theirs)) {
+            score += extendWeights[Qubic_CountBits(line & mine)];
+        } else if (!(line & mine)) {
+            score += blockWeights[Qubic_CountBits(line & theirs)];
+        }
+    }
+    return score;
+}
+
+static inline int Qubic_OrderMoves(QubicBits candidates, QubicBits mine, QubicBits theirs, int firstMove, int* moves) {
+    int scores[QUBIC_SIZE];
+    int count = 0;
+    while (candidates) {
+        int const cell  = __builtin_ctzll(candidates);
+        int const score = cell == firstMove ? INT_MAX : Qubic_ScoreMove(mine, theirs, cell);
+        candidates &= candidates - 1;
+
+        int slot = count++;
+        for (; slot > 0 && scores[slot - 1] < score; --slot) {
+            scores[slot] = scores[slot - 1];
+            moves[slot]  = moves[slot - 1];
+        }
+        scores[slot] = score;
+        moves[slot]  = cell;
+    }
+    return count;
+}
+
+static inline int Qubic_Negamax(SearchContext* search, QubicBits mine, QubicBits theirs, int depth, int alpha, int beta, int ply) { // NOLINT
+    if (Search_IsAborted(search)) { return 0; }
+
+    QubicBits const empty = ~(mine | theirs);
+    if (!empty) { return 0; }
+    if (Qubic_GetThreats(mine, theirs) & empty) { return SEARCH_SCORE_WIN - ply; }
+
+    // A single opponent threat forces the reply, which is searched without spending depth;
+    // two or more cannot all be blocked.
+    QubicBits const forced = Qubic_GetThreats(theirs, mine) & empty;
+    if (forced & (forced - 1)) { return -(SEARCH_SCORE_WIN - ply - 1); }
+    if (depth <= 0 && !forced) { return Qubic_EvaluateStatic(mine, theirs); }
+
+    QubicBits const         key        = Qubic_Hash(mine, theirs);
+    SearchCacheEntry* const entry      = Search_GetCacheEntry(search, key);
+    int                     cacheScore = 0;
+    int                     cacheMove  = -1;
+    if (Search_ProbeCache(search, entry, key, depth, ply, &alpha, &beta, &cacheScore, &cacheMove)) { return cacheScore; }
+
+    int       moves[QUBIC_SIZE];
+    int const moveCount   = Qubic_OrderMoves(forced ? forced : empty, mine, theirs, cacheMove, moves);
+    int const nextDepth   = forced ? depth : depth - 1;
+    int const alphaOrigin = alpha;
+    int       bestScore   = -SEARCH_SCORE_INFINITY;
+    int       bestMove    = moves[0];
+    for (int i = 0; i < moveCount && alpha < beta; ++i) {
+        int const score = -Qubic_Negamax(search, theirs, mine | 1ULL << moves[i], nextDepth, -beta, -alpha, ply + 1);
+        if (search->isAborted) { return 0; }
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove  = moves[i];
+        }
+        alpha = max(alpha, score);
+    }
+
+    Search_StoreCache(search, entry, key, depth, ply, bestScore, alphaOrigin, beta, bestMove);
+    return bestScore;
+}
+
+static inline int Qubic_SearchRootMove(SearchContext* search, const void* position, int move, int depth, int alpha) {
+    QubicPosition const* const root = position;
+    return -Qubic_Negamax(search, root->theirs, root->mine | 1ULL << move, depth - 1, -SEARCH_SCORE_INFINITY, -alpha, 1);
+}
+
+// Easy (difficulty 1) plays a random empty tile. Otherwise iterative deepening runs until a forced result
+// is found or QUBIC_TIME_BUDGET_MS runs out, and the best move of the last completed depth is played.
+static inline int Qubic_GetAIMove(int difficulty, const BoardTile* board, BoardTile player, BoardTile opponent) {
+    (void)opponent;
+    QubicBits mine   = 0;
+    QubicBits theirs = 0;
+    Qubic_ToBits(board, player, &mine, &theirs);
+    QubicBits const empty = ~(mine | theirs);
+
+    if (difficulty == 1) {
+        int aiMove = 0;
+        do {
+            aiMove = rand() % QUBIC_SIZE; // NOLINT
+        } while (!(empty >> aiMove & 1));
+        return aiMove;
+    }
+
+    QubicBits const wins = Qubic_GetThreats(mine, theirs) & empty;
+    if (wins) { return __builtin_ctzll(wins); }
+    QubicBits const forced = Qubic_GetThreats(theirs, mine) & empty;
+
+    SearchContext       search    = Search_Begin(qubicCache, QUBIC_CACHE_SIZE, QUBIC_TIME_BUDGET_MS, QUBIC_SIZE);
+    QubicPosition const position  = { mine, theirs };
+    int                 moves[QUBIC_SIZE] = { 0 };
+    int const           moveCount = Qubic_OrderMoves(forced ? forced : empty, mine, theirs, -1, moves);
+    return Search_IterativeDeepening(&search, &position, Qubic_SearchRootMove, moves, moveCount, min(QUBIC_DEPTH_MAX, moveCount), "Qubic_GetAIMove root move");
+}
+// #endregion // Qubic_Search
+
+#endif // TIC_TAC_TOE_QUBIC_H
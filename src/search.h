@@ -0,0 +1,150 @@
+/**
+ * @file search.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Transposition cache, time budget and iterative-deepening root shared by the alpha-beta searches.
+    Each game supplies its own position type, hash, move generation and negamax; this is everything around them.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_SEARCH_H
+#define TIC_TAC_TOE_SEARCH_H
+
+// #region Header_Inclusion
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "trace.h"
+// #endregion // Header_Inclusion
+
+enum {
+    // Proven results sit at +-(SEARCH_SCORE_WIN - ply); static evaluations stay well inside.
+    SEARCH_SCORE_WIN       = 30000,
+    SEARCH_SCORE_INFINITY  = 32000,
+    SEARCH_NODE_CHECK_MASK = 1023,
+};
+
+// How a stored score relates to the node's true score: equal, at least (fail high) or at most (fail low).
+typedef enum eSearchBound {
+    SearchBound_Exact = 0,
+    SearchBound_Lower,
+    SearchBound_Upper
+} SearchBound;
+
+typedef struct SearchCacheEntry {
+    unsigned long long key;
+    short              score;
+    signed char        depth;
+    unsigned char      bound;
+    unsigned char      move;
+} SearchCacheEntry;
+
+typedef struct SearchContext {
+    SearchCacheEntry*  cache;
+    unsigned long long cacheMask;     // entry count - 1, a power of two minus one
+    clock_t            deadline;
+    long long          nodeCount;
+    int                decisiveScore; // scores at least this far from zero are forced results
+    bool               isAborted;
+} SearchContext;
+
+// Starts a search over `cache` (`cacheSize` entries, a power of two) in games of at most `plyMax` plies.
+static inline SearchContext Search_Begin(SearchCacheEntry* cache, size_t cacheSize, int timeBudgetMS, int plyMax) {
+    SearchContext search = { cache, cacheSize - 1, clock() + (clock_t)timeBudgetMS * CLOCKS_PER_SEC / 1000, 0, SEARCH_SCORE_WIN - plyMax, false };
+    return search;
+}
+
+// Counts a node and checks the clock every SEARCH_NODE_CHECK_MASK + 1 of them; once out of time, stays aborted.
+static inline bool Search_IsAborted(SearchContext* search) {
+    if ((++search->nodeCount & SEARCH_NODE_CHECK_MASK) == 0 && clock() > search->deadline) { search->isAborted = true; }
+    return search->isAborted;
+}
+
+static inline bool Search_IsDecisive(const SearchContext* search, int score) { return score >= search->decisiveScore || score <= -search->decisiveScore; }
+
+static inline SearchCacheEntry* Search_GetCacheEntry(const SearchContext* search, unsigned long long key) { return &search->cache[key & search->cacheMask]; }
+
+// Scores of forced wins are stored relative to the node so that they stay valid at any ply.
+static inline int Search_ScoreToCache(const SearchContext* search, int score, int ply) {
+    return score >= search->decisiveScore ? score + ply : (score <= -search->decisiveScore ? score - ply : score);
+}
+
+static inline int Search_ScoreFromCache(const SearchContext* search, int score, int ply) {
+    return score >= search->decisiveScore ? score - ply : (score <= -search->decisiveScore ? score + ply : score);
+}
+
+static inline SearchBound Search_GetBound(int bestScore, int alphaOrigin, int beta) {
+    return bestScore <= alphaOrigin ? SearchBound_Upper : (bestScore >= beta ? SearchBound_Lower : SearchBound_Exact);
+}
+
+// Narrows [alpha, beta] by `bound` on `score`. Returns true when that settles the node at `score`.
+static inline bool Search_ApplyBound(SearchBound bound, int score, int* alpha, int* beta) {
+    if (bound == SearchBound_Exact) { return true; }
+    if (bound == SearchBound_Lower && score > *alpha) { *alpha = score; }
+    if (bound == SearchBound_Upper && score < *beta) { *beta = score; }
+    return *alpha >= *beta;
+}
+
+// Uses `entry` of `key` when it was searched at least `depth` plies deep; returns true with the node's score in
+// `score` when it settles the node. `move` receives the entry's best move, or -1 when the entry is another position's.
+static inline bool Search_ProbeCache(const SearchContext* search, const SearchCacheEntry* entry, unsigned long long key, int depth, int ply, int* alpha, int* beta, int* score, int* move) {
+    *move = -1;
+    if (entry->key != key) { return false; }
+    *move = entry->move;
+    if (entry->depth < depth) { return false; }
+    *score = Search_ScoreFromCache(search, entry->score, ply);
+    return Search_ApplyBound((SearchBound)entry->bound, *score, alpha, beta);
+}
+
+static inline void Search_StoreCache(const SearchContext* search, SearchCacheEntry* entry, unsigned long long key, int depth, int ply, int bestScore, int alphaOrigin, int beta, int bestMove) {
+    entry->key   = key;
+    entry->score = (short)Search_ScoreToCache(search, bestScore, ply);
+    entry->depth = (signed char)depth;
+    entry->bound = (unsigned char)Search_GetBound(bestScore, alphaOrigin, beta);
+    entry->move  = (unsigned char)bestMove;
+}
+
+// Returns the root's score after playing `move` in `position`, searched `depth` plies deep (the move included),
+// or anything once `search` is aborted. Scores at or below `alpha` may be reported as `alpha`.
+typedef int (*SearchRootMove)(SearchContext* search, const void* position, int move, int depth, int alpha);
+
+// Searches `moves` (best guess first) one ply deeper at a time until a forced result is found, `depthMax` is
+// reached or the time budget runs out, and returns the best move of the last completed depth. Each depth starts
+// with the previous best move; `moves` is reordered in place.
+static inline int Search_IterativeDeepening(SearchContext* search, const void* position, SearchRootMove searchRootMove, int* moves, int moveCount, int depthMax, const char* traceName) {
+    (void)traceName; // only used when tracing
+    int bestMove = moves[0];
+    for (int depth = 1; depth <= depthMax; ++depth) {
+        int depthScore = -SEARCH_SCORE_INFINITY;
+        int depthMove  = moves[0];
+        for (int i = 0; i < moveCount && !search->isAborted; ++i) {
+            TRACE_SCOPE_ARG(traceName, moves[i]) {
+                int const score = searchRootMove(search, position, moves[i], depth, depthScore);
+                if (!search->isAborted && score > depthScore) {
+                    depthScore = score;
+                    depthMove  = moves[i];
+                }
+            }
+        }
+        if (search->isAborted) { break; }
+
+        bestMove = depthMove;
+        // search the best move first at the next depth
+        for (int i = 0; moves[0] != depthMove; ++i) {
+            if (moves[i] == depthMove) {
+                moves[i] = moves[0];
+                moves[0] = depthMove;
+            }
+        }
+        if (Search_IsDecisive(search, depthScore)) { break; }
+    }
+    return bestMove;
+}
+
+#endif // TIC_TAC_TOE_SEARCH_H
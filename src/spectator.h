@@ -0,0 +1,155 @@
+/**
+ * @file spectator.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Live game feed published into a memory-mapped ring buffer for external monitors.
+    One game process writes; any number of readers map the same file read-only and tail it.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_SPECTATOR_H
+#define TIC_TAC_TOE_SPECTATOR_H
+
+// #region Header_Inclusion
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "engine.h"
+#include "mapped_file.h"
+// #endregion // Header_Inclusion
+
+enum {
+    SPECTATOR_MAGIC          = 0x46545454, // "TTTF"
+    SPECTATOR_VERSION        = 2,
+    SPECTATOR_SLOT_COUNT     = 256,
+    SPECTATOR_TILE_COUNT_MAX = 128,
+    SPECTATOR_MESSAGE_COUNT  = 4,
+    SPECTATOR_MESSAGE_LENGTH = 64,
+};
+
+// Numbered like the game's GameVariant.
+typedef enum eSpectatorVariant {
+    SpectatorVariant_Classic = 0,
+    SpectatorVariant_Qubic,
+    SpectatorVariant_Ultimate
+} SpectatorVariant;
+
+// Frame n lives in slot n % SPECTATOR_SLOT_COUNT. Its sequence is 2n + 1 while the game writes it and 2n + 2
+// once complete, so a reader that sees the same even value before and after reading knows the frame is intact.
+typedef struct SpectatorFrame {
+    atomic_ullong sequence;
+    int           variant; // SpectatorVariant
+    int           turnCount;
+    int           tileCount;
+    int           messageCount;
+    signed char   currentPlayer;
+    bool          isOver;
+    signed char   board[SPECTATOR_TILE_COUNT_MAX];
+    char          messages[SPECTATOR_MESSAGE_COUNT][SPECTATOR_MESSAGE_LENGTH];
+} SpectatorFrame;
+
+typedef struct SpectatorFeed {
+    unsigned int   magic;
+    unsigned int   version;
+    unsigned int   slotCount;
+    unsigned int   frameSize;
+    atomic_uint    generation; // incremented by every Spectator_Open(), so readers notice a new game process
+    atomic_ullong  head;       // number of the last complete frame, 0 before the first
+    SpectatorFrame frames[SPECTATOR_SLOT_COUNT];
+} SpectatorFeed;
+
+static MappedFile spectatorWriter;
+
+// #region Spectator_Writer
+// Accepts an empty file or a feed of any version, including one whose writer stopped while resetting it
+// (magic still cleared); anything else at the path is left untouched.
+static inline bool Spectator_CheckFile(const void* head, unsigned long long length) {
+    unsigned int magic   = 0;
+    unsigned int version = 0;
+    memcpy(&magic, (const char*)head + offsetof(SpectatorFeed, magic), sizeof(magic));
+    memcpy(&version, (const char*)head + offsetof(SpectatorFeed, version), sizeof(version));
+    return length == 0 || magic == SPECTATOR_MAGIC || (magic == 0 && version <= SPECTATOR_VERSION);
+}
+
+// Reuses the file in place rather than truncating it: readers may still have it mapped, and touching a mapping
+// past the end of a truncated file faults. They see the generation change and start over.
+static inline bool Spectator_Open(const char* path) {
+    SpectatorFeed* feed = MappedFile_Open(&spectatorWriter, path, sizeof(SpectatorFeed), MappedFile_Shared, Spectator_CheckFile);
+    if (!feed) { return false; }
+
+    feed->magic = 0;
+    atomic_thread_fence(memory_order_release);
+    feed->version   = SPECTATOR_VERSION;
+    feed->slotCount = SPECTATOR_SLOT_COUNT;
+    feed->frameSize = sizeof(SpectatorFrame);
+    atomic_fetch_add_explicit(&feed->generation, 1, memory_order_relaxed);
+    // a reader that sees the head reset also sees the new generation
+    atomic_store_explicit(&feed->head, 0, memory_order_release);
+    for (int i = 0; i < SPECTATOR_SLOT_COUNT; ++i) {
+        atomic_store_explicit(&feed->frames[i].sequence, 0, memory_order_relaxed);
+    }
+    // readers check the magic last
+    atomic_thread_fence(memory_order_release);
+    feed->magic = SPECTATOR_MAGIC;
+    return true;
+}
+
+static inline void Spectator_Close() { MappedFile_Close(&spectatorWriter); }
+
+// Writes the next frame without waiting for readers; a reader that falls a whole ring behind skips frames.
+static inline void Spectator_Publish(int variant, const BoardTile* board, int tileCount, int turnCount, int currentPlayer, bool isOver, const char* const* messages, int messageCount) {
+    SpectatorFeed* const feed = spectatorWriter.view;
+    if (!feed) { return; }
+
+    unsigned long long const number = atomic_load_explicit(&feed->head, memory_order_relaxed) + 1;
+    SpectatorFrame* const    frame  = &feed->frames[number % SPECTATOR_SLOT_COUNT];
+    atomic_store_explicit(&frame->sequence, 2 * number + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    frame->variant       = variant;
+    frame->turnCount     = turnCount;
+    frame->tileCount     = tileCount < SPECTATOR_TILE_COUNT_MAX ? tileCount : SPECTATOR_TILE_COUNT_MAX;
+    frame->currentPlayer = (signed char)currentPlayer;
+    frame->isOver        = isOver;
+    for (int i = 0; i < frame->tileCount; ++i) { frame->board[i] = (signed char)board[i]; }
+    frame->messageCount = messageCount < SPECTATOR_MESSAGE_COUNT ? messageCount : SPECTATOR_MESSAGE_COUNT;
+    for (int i = 0; i < frame->messageCount; ++i) {
+        strncpy(frame->messages[i], messages[i] ? messages[i] : "", SPECTATOR_MESSAGE_LENGTH - 1);
+        frame->messages[i][SPECTATOR_MESSAGE_LENGTH - 1] = '\0';
+    }
+
+    atomic_store_explicit(&frame->sequence, 2 * number + 2, memory_order_release);
+    atomic_store_explicit(&feed->head, number, memory_order_release);
+}
+// #endregion // Spectator_Writer
+
+// #region Spectator_Reader
+static inline bool Spectator_IsValid(const SpectatorFeed* feed) {
+    return feed->magic == SPECTATOR_MAGIC && feed->version == SPECTATOR_VERSION && feed->slotCount == SPECTATOR_SLOT_COUNT && feed->frameSize == sizeof(SpectatorFrame);
+}
+
+static inline unsigned int Spectator_GetGeneration(SpectatorFeed* feed) { return atomic_load_explicit(&feed->generation, memory_order_acquire); }
+
+static inline unsigned long long Spectator_GetHead(SpectatorFeed* feed) { return atomic_load_explicit(&feed->head, memory_order_acquire); }
+
+// Returns frame `number` in place, or NULL when it has been overwritten or is being written.
+// Anything read from it is only trustworthy if Spectator_EndRead() then returns true.
+static inline const SpectatorFrame* Spectator_BeginRead(SpectatorFeed* feed, unsigned long long number) {
+    SpectatorFrame* const frame = &feed->frames[number % SPECTATOR_SLOT_COUNT];
+    return atomic_load_explicit(&frame->sequence, memory_order_acquire) == 2 * number + 2 ? frame : NULL;
+}
+
+static inline bool Spectator_EndRead(const SpectatorFrame* frame, unsigned long long number) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&((SpectatorFrame*)frame)->sequence, memory_order_relaxed) == 2 * number + 2;
+}
+// #endregion // Spectator_Reader
+
+#endif // TIC_TAC_TOE_SPECTATOR_H
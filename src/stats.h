@@ -0,0 +1,134 @@
+/**
+ * @file stats.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Game results kept in a fixed-layout memory-mapped file.
+    Every counter is updated with a single atomic add, so any number of game processes can share the file.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_STATS_H
+#define TIC_TAC_TOE_STATS_H
+
+// #region Header_Inclusion
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "mapped_file.h"
+// #endregion // Header_Inclusion
+
+enum {
+    STATS_MAGIC            = 0x53545454, // "TTTS"
+    STATS_VERSION          = 1,
+    STATS_VARIANT_COUNT    = 4,
+    STATS_MODE_COUNT       = 3,
+    STATS_DIFFICULTY_COUNT = 2,
+    STATS_OPENING_COUNT    = 128,
+};
+
+typedef enum eStatsMode {
+    StatsMode_PlayerVsPlayer = 0,
+    StatsMode_PlayerVsAI,
+    StatsMode_AIVsAI
+} StatsMode;
+
+typedef enum eStatsResult {
+    StatsResult_PlayerOneWon = 0,
+    StatsResult_PlayerTwoWon,
+    StatsResult_Draw,
+    StatsResult_Count
+} StatsResult;
+
+typedef struct StatsCounters {
+    atomic_ullong results[StatsResult_Count];
+} StatsCounters;
+
+// The layout only ever grows at the end, which raises `size` but keeps `version`; the version changes only when
+// existing counters move. A file written by an earlier build (same version, smaller size) is extended and its new
+// counters start at zero. A file from a later build (larger size), of another version, or not a statistics
+// file at all is left untouched.
+typedef struct StatsFile {
+    atomic_uint   magic;
+    unsigned int  version;
+    unsigned int  size;
+    StatsCounters byMode[STATS_VARIANT_COUNT][STATS_MODE_COUNT][STATS_DIFFICULTY_COUNT];
+    StatsCounters byOpening[STATS_VARIANT_COUNT][STATS_OPENING_COUNT];
+} StatsFile;
+
+static MappedFile statsMapping;
+static StatsFile* statsFile;
+
+// Accepts an empty file, one another process is creating (header still zero), or a statistics file of this
+// version no larger than this build's layout whose recorded size the file really holds.
+static inline bool Stats_CheckFile(const void* head, unsigned long long length) {
+    unsigned int magic   = 0;
+    unsigned int version = 0;
+    unsigned int size    = 0;
+    memcpy(&magic, (const char*)head + offsetof(StatsFile, magic), sizeof(magic));
+    memcpy(&version, (const char*)head + offsetof(StatsFile, version), sizeof(version));
+    memcpy(&size, (const char*)head + offsetof(StatsFile, size), sizeof(size));
+    if (magic == 0 && version == 0 && size == 0) { return length <= sizeof(StatsFile); }
+    return magic == STATS_MAGIC && version == STATS_VERSION && size >= offsetof(StatsFile, byMode) && size <= sizeof(StatsFile) && size <= length;
+}
+
+// Maps (creating it if needed) the statistics file. Recording and reading are no-ops when this fails.
+static inline bool Stats_Open(const char* path) {
+    StatsFile* file = MappedFile_Open(&statsMapping, path, sizeof(StatsFile), MappedFile_Shared, Stats_CheckFile);
+    if (!file) { return false; }
+
+    // a new file is all zeros; every process that finds it so writes the same header
+    unsigned int expected = 0;
+    if (atomic_load(&file->magic) == 0) {
+        file->version = STATS_VERSION;
+        file->size    = sizeof(StatsFile);
+        (void)atomic_compare_exchange_strong(&file->magic, &expected, STATS_MAGIC);
+    }
+    if (atomic_load(&file->magic) != STATS_MAGIC || file->version != STATS_VERSION || file->size > sizeof(StatsFile)) {
+        MappedFile_Close(&statsMapping);
+        return false;
+    }
+    if (file->size < sizeof(StatsFile)) {
+        // an earlier build's file: its counters stay where they are and the ones added since start at zero
+        memset((char*)file + file->size, 0, sizeof(StatsFile) - file->size);
+        file->size = sizeof(StatsFile);
+    }
+    statsFile = file;
+    return true;
+}
+
+static inline void Stats_Close() {
+    MappedFile_Close(&statsMapping);
+    statsFile = NULL;
+}
+
+static inline bool Stats_IsOpen() { return statsFile != NULL; }
+
+static inline void Stats_Record(int variant, StatsMode mode, int difficulty, int opening, StatsResult result) {
+    if (!statsFile || variant < 0 || variant >= STATS_VARIANT_COUNT) { return; }
+
+    (void)atomic_fetch_add_explicit(&statsFile->byMode[variant][mode][difficulty].results[result], 1, memory_order_relaxed);
+    if (opening >= 0 && opening < STATS_OPENING_COUNT) {
+        (void)atomic_fetch_add_explicit(&statsFile->byOpening[variant][opening].results[result], 1, memory_order_relaxed);
+    }
+}
+
+static inline unsigned long long Stats_GetCount(const StatsCounters* counters, StatsResult result) {
+    return atomic_load_explicit(&((StatsCounters*)counters)->results[result], memory_order_relaxed);
+}
+
+static inline unsigned long long Stats_GetGameCount(const StatsCounters* counters) {
+    unsigned long long count = 0;
+    for (int i = 0; i < StatsResult_Count; ++i) {
+        count += Stats_GetCount(counters, (StatsResult)i);
+    }
+    return count;
+}
+
+#endif // TIC_TAC_TOE_STATS_H
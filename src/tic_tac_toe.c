@@ -20,26 +20,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+
+#include "engine.h"
+#include "headless.h"
+#include "qubic.h"
+#include "spectator.h"
+#include "stats.h"
+#include "ultimate.h"
 // #endregion // Header_Inclusion
 
-// #region Pre-process_Definitions
-#define max(_a, _b) (((_a) > (_b)) ? (_a) : (_b))
-#define min(_a, _b) (((_a) < (_b)) ? (_a) : (_b))
-#define swap(_T, _a, _b) \
-    do {                 \
-        _T __t = (_a);   \
-        (_a)   = (_b);   \
-        (_b)   = __t;    \
-    } while (0)
-// #endregion // Pre-process_Definitions
+#if BOARD_WIDTH != 3
+#error "The console front-end lays out the 3x3 board only; larger boards are for the engine tools."
+#endif
 
 
 
 enum {
-    MESSAGE_COUNT_MAX = 4,
-    MINIMAX_DEPTH     = 8,
-    BOARD_SIZE        = 9,
-    INPUT_MAP_SIZE    = 256,
+    MESSAGE_COUNT_MAX   = 4,
+    MESSAGE_TEXT_SIZE   = 48,
+    MINIMAX_DEPTH       = 8,
+    INPUT_MAP_SIZE      = 256,
+    GAME_TILE_COUNT_MAX = ULTIMATE_SIZE,
 };
 
 static inline void Assert(int condition, const char* message) {
@@ -50,6 +51,7 @@ static inline void Assert(int condition, const char* message) {
 }
 
 static inline void Delay(clock_t waitMS) {
+    if (Headless_IsScripted()) { return; }
     clock_t endMS = waitMS + clock();
     while (endMS > clock()) { ; }
 }
@@ -80,9 +82,11 @@ typedef enum eSceneStateType {
 typedef enum eMenuStateType {
     MenuState_None = 0,
     MenuState_Main,
+    MenuState_SelectionBoard,
     MenuState_SelectionPlayMode,
     MenuState_SelectionAILevel,
-    MenuState_SelectionPlayerOrder
+    MenuState_SelectionPlayerOrder,
+    MenuState_Statistics
 } MenuStateType;
 
 typedef enum ePlayerType {
@@ -91,14 +95,16 @@ typedef enum ePlayerType {
     Player_Human
 } PlayerType;
 
-typedef enum eBoardTile {
-    BoardTile_PlayerTwo   = -1,
-    BoardTile_PlayerEmpty = 0,
-    BoardTile_PlayerOne   = 1,
-} BoardTile;
+typedef enum eGameVariant {
+    GameVariant_Classic = 0,
+    GameVariant_Qubic,
+    GameVariant_Ultimate
+} GameVariant;
+_Static_assert(GameVariant_Qubic == (int)SpectatorVariant_Qubic && GameVariant_Ultimate == (int)SpectatorVariant_Ultimate, "The spectator feed numbers variants like GameVariant");
 
 // TODO(DevDasae): Implement State Machine
 typedef struct Scene {
+    const char* name;
     void (*ProcessInput)();
     void (*Update)();
     void (*Draw)();
@@ -107,20 +113,23 @@ typedef struct Scene {
 typedef struct Menu_SceneData {
     MenuStateType currentState;
     bool          redraws;
+    GameVariant   selectedVariant;
+    PlayerType    selectedPlayers[2];
 } Menu_SceneData;
-Menu_SceneData menuData = { MenuState_Main, false };
+Menu_SceneData menuData = { MenuState_Main, false, GameVariant_Classic, { Player_None, Player_None } };
 void           Menu_ProcessInput();
 void           Menu_Update();
 void           Menu_Draw();
-static Scene   sceneMenu = { Menu_ProcessInput, Menu_Update, Menu_Draw };
+static Scene   sceneMenu = { "Menu", Menu_ProcessInput, Menu_Update, Menu_Draw };
 
 static const char* MESSAGE_EMPTY                  = NULL;
 static const char* MESSAGE_SELECT_TILE            = "Select tile.";
 static const char* MESSAGE_BoardTile_IS_NOT_EMPTY = "This tile cannot be selected.";
+static const char* MESSAGE_SUB_BOARD_IS_NOT_OPEN  = "Play in the marked board.";
 
 typedef struct Game_SceneData {
     PlayerType players[2];
-    BoardTile  board[BOARD_SIZE];
+    BoardTile  board[GAME_TILE_COUNT_MAX];
     BoardTile  currentPlayer;
     BoardTile  currentOpponent;
     int        aiDifficulty;
@@ -130,12 +139,22 @@ typedef struct Game_SceneData {
     bool       redraws;
     bool       isOver;
     bool       toggleTileHint;
+    bool       toggleAnalysis;
     bool       enqueuesAiMessage;
     // game message queue
     const char* messageQueue[MESSAGE_COUNT_MAX];
+    char        messageText[MESSAGE_COUNT_MAX][MESSAGE_TEXT_SIZE]; // copies owned by the slot of the same index
     size_t      messageHead;
     size_t      messageTail;
     size_t      messageCount;
+    // move stack for undo/redo (entries past moveCount are redoable)
+    int moveHistory[GAME_TILE_COUNT_MAX];
+    int moveCount;
+    int moveRedoCount;
+    // board variant, and the tile under the cursor for boards without one key per tile
+    GameVariant variant;
+    int         tileCount;
+    int         cursorTile;
 } Game_SceneData;
 Game_SceneData gameData = {
     { Player_None, Player_None },
@@ -150,22 +169,31 @@ Game_SceneData gameData = {
     false,
     false,
     false,
+    false,
     {
         NULL,
         0,
         0,
         0,
     },
+    { { 0 } },
+    0,
+    0,
+    0,
+    { 0 },
     0,
     0,
+    GameVariant_Classic,
+    BOARD_SIZE,
     0
 };
-void         Game_Initialize(PlayerType player1, PlayerType player2);
+void         Game_Initialize(GameVariant variant, PlayerType player1, PlayerType player2, int aiDifficulty);
 void         Game_ProcessInput();
 void         Game_Update();
 void         Game_Draw();
 void         Game_Finalize();
-static Scene sceneGame = { Game_ProcessInput, Game_Update, Game_Draw };
+void         GetTileName(GameVariant variant, int tile, char* name, size_t size);
+static Scene sceneGame = { "Game", Game_ProcessInput, Game_Update, Game_Draw };
 
 typedef struct Exit_SceneData {
     bool redraws;
@@ -177,18 +205,30 @@ void         Quit_ProcessInput();
 void         Quit_Update();
 void         Quit_Draw();
 static Scene sceneExit = {
+    "Quit",
     Quit_ProcessInput,
     Quit_Update,
     Quit_Draw
 };
 
+static AnalysisCache analysisCache;
+
 static Scene* currentScene = &sceneMenu;
 static int    inputKey     = 0;
 static bool   isRunning    = true;
+static bool   isFrameBusy  = false; // a key was read or something was drawn
 
 int GetInputKey() {
+    if (Headless_IsScripted()) {
+        int const key = Headless_GetKey();
+        // the run ends with its script
+        if (Headless_IsScriptDone()) { SetRunning(false); }
+        isFrameBusy = isFrameBusy || key != -1;
+        return key;
+    }
     if (kbhit()) {
-        int key = getch();
+        isFrameBusy = true;
+        int key     = getch();
         if (key == 0xE0 || key == 0) {
             return getch();
         }
@@ -225,9 +265,13 @@ void Menu_Update() {
         switch (inputKey) {
         case 1:
             menuData.redraws      = false;
-            menuData.currentState = MenuState_SelectionPlayMode;
+            menuData.currentState = MenuState_SelectionBoard;
             break;
         case 2:
+            menuData.redraws      = false;
+            menuData.currentState = MenuState_Statistics;
+            break;
+        case 3:
             menuData.redraws = false;
             currentScene     = &sceneExit;
             break;
@@ -235,20 +279,60 @@ void Menu_Update() {
             break;
         }
         break;
+    case MenuState_SelectionBoard:
+        switch (inputKey) {
+        case -1:
+            return;
+        case 1:
+            menuData.selectedVariant = GameVariant_Classic;
+            menuData.currentState    = MenuState_SelectionPlayMode;
+            break;
+        case 2:
+            menuData.selectedVariant = GameVariant_Qubic;
+            menuData.currentState    = MenuState_SelectionPlayMode;
+            break;
+        case 3:
+            menuData.selectedVariant = GameVariant_Ultimate;
+            menuData.currentState    = MenuState_SelectionPlayMode;
+            break;
+        default:
+            menuData.currentState = MenuState_Main;
+            break;
+        }
+        menuData.redraws = false;
+        break;
     case MenuState_SelectionPlayMode:
         switch (inputKey) {
         case -1:
             return;
         case 1:
-            Game_Initialize(Player_Human, Player_Human);
-            currentScene = &sceneGame;
+            Game_Initialize(menuData.selectedVariant, Player_Human, Player_Human, 1);
+            currentScene          = &sceneGame;
+            menuData.currentState = MenuState_Main;
             break;
         case 2:
-            Game_Initialize(Player_Human, Player_AI);
-            currentScene = &sceneGame;
+            menuData.selectedPlayers[0] = Player_Human;
+            menuData.selectedPlayers[1] = Player_AI;
+            menuData.currentState       = MenuState_SelectionAILevel;
             break;
         case 3:
-            Game_Initialize(Player_AI, Player_AI);
+            menuData.selectedPlayers[0] = Player_AI;
+            menuData.selectedPlayers[1] = Player_AI;
+            menuData.currentState       = MenuState_SelectionAILevel;
+            break;
+        default:
+            menuData.currentState = MenuState_Main;
+            break;
+        }
+        menuData.redraws = false;
+        break;
+    case MenuState_SelectionAILevel:
+        switch (inputKey) {
+        case -1:
+            return;
+        case 1:
+        case 2:
+            Game_Initialize(menuData.selectedVariant, menuData.selectedPlayers[0], menuData.selectedPlayers[1], inputKey == 1 ? 1 : MINIMAX_DEPTH);
             currentScene = &sceneGame;
         default:
             break;
@@ -256,20 +340,92 @@ void Menu_Update() {
         menuData.redraws      = false;
         menuData.currentState = MenuState_Main;
         break;
+    case MenuState_Statistics:
+        if (inputKey == -1) { return; }
+        menuData.redraws      = false;
+        menuData.currentState = MenuState_Main;
+        break;
     default:
         break;
     }
 }
 
+static const char* const statsVariantNames[] = { "Classic", "Qubic", "Ultimate" };
+static const char* const statsModeNames[][STATS_DIFFICULTY_COUNT] = {
+    { "Player vs Player", "Player vs Player" },
+    { "Player vs A.I. Easy", "Player vs A.I. Hard" },
+    { "A.I. Easy vs A.I. Easy", "A.I. Hard vs A.I. Hard" },
+};
+
+static inline int GetStatsPercent(unsigned long long count, unsigned long long total) { return total ? (int)(count * 100 / total) : 0; }
+
+// Reads a fixed number of counters, so it takes the same time however many games were recorded.
+void Menu_DrawStatistics() {
+    puts("Statistics\n");
+    if (!Stats_IsOpen()) {
+        puts("The statistics file could not be opened.\n");
+        puts("- Press any key to go to menu");
+        return;
+    }
+
+    printf("%-9s %-23s %8s %7s %7s %7s\n", "Board", "Mode", "Games", "1P won", "2P won", "Draws");
+    for (int variant = 0; variant < (int)(sizeof(statsVariantNames) / sizeof(statsVariantNames[0])); ++variant) {
+        for (int mode = 0; mode < STATS_MODE_COUNT; ++mode) {
+            for (int difficulty = 0; difficulty < STATS_DIFFICULTY_COUNT; ++difficulty) {
+                StatsCounters const*     counters = &statsFile->byMode[variant][mode][difficulty];
+                unsigned long long const games    = Stats_GetGameCount(counters);
+                if (!games) { continue; }
+                printf("%-9s %-23s %8llu %6d%% %6d%% %6d%%\n", statsVariantNames[variant], statsModeNames[mode][difficulty], games, GetStatsPercent(Stats_GetCount(counters, StatsResult_PlayerOneWon), games), GetStatsPercent(Stats_GetCount(counters, StatsResult_PlayerTwoWon), games), GetStatsPercent(Stats_GetCount(counters, StatsResult_Draw), games));
+            }
+        }
+    }
+
+    puts("\nMost played openings");
+    for (int variant = 0; variant < (int)(sizeof(statsVariantNames) / sizeof(statsVariantNames[0])); ++variant) {
+        int                bestOpening = -1;
+        unsigned long long bestGames   = 0;
+        for (int opening = 0; opening < STATS_OPENING_COUNT; ++opening) {
+            unsigned long long const games = Stats_GetGameCount(&statsFile->byOpening[variant][opening]);
+            if (games > bestGames) {
+                bestGames   = games;
+                bestOpening = opening;
+            }
+        }
+        if (bestOpening < 0) { continue; }
+
+        char name[16];
+        GetTileName((GameVariant)variant, bestOpening, name, sizeof(name));
+        StatsCounters const* counters = &statsFile->byOpening[variant][bestOpening];
+        printf("%-9s %-23s %8llu %6d%% %6d%% %6d%%\n", statsVariantNames[variant], name, bestGames, GetStatsPercent(Stats_GetCount(counters, StatsResult_PlayerOneWon), bestGames), GetStatsPercent(Stats_GetCount(counters, StatsResult_PlayerTwoWon), bestGames), GetStatsPercent(Stats_GetCount(counters, StatsResult_Draw), bestGames));
+    }
+    puts("\n- Press any key to go to menu");
+}
+
 void Menu_Draw() {
     if (menuData.redraws) { return; }
+    isFrameBusy = true;
     DoSystemCls();
     switch (menuData.currentState) {
     case MenuState_Main:
         puts("Tic Tac Toe\n");
 
         puts("1. New Game");
-        puts("2. Quit");
+        puts("2. Statistics");
+        puts("3. Quit");
+        break;
+
+    case MenuState_Statistics:
+        Menu_DrawStatistics();
+        break;
+
+    case MenuState_SelectionBoard:
+        puts("Select Game Board\n");
+
+        puts("- 1. Classic 3x3");
+        puts("- 2. Qubic 4x4x4");
+        puts("- 3. Ultimate 9x9\n");
+
+        puts("- or Go To Menu");
         break;
 
     case MenuState_SelectionPlayMode:
@@ -339,17 +495,35 @@ unsigned char GetTileByPlayer(int tileIndex) {
     }
 }
 
+// `$c` is one three-column cell: its tile, or the tile's move value while the overlay is on.
 static const char* boardLayout = "\
-0$c0|0$c0|0$c$n\
+$c|$c|$c$n\
 ---+---+---$n\
-0$c0|0$c0|0$c$n\
+$c|$c|$c$n\
 ---+---+---$n\
-0$c0|0$c0|0$c$n\
+$c|$c|$c$n\
 ";
 
+// Prints the cell of `tileIndex`, or its value in `scores` when there is one.
+static void DrawGameBoardCell(int tileIndex, const int* scores) {
+    if (!scores || scores[tileIndex] == ANALYSIS_SCORE_NONE) {
+        printf(" %c ", GetTileByPlayer(tileIndex));
+    } else if (scores[tileIndex] == 0) {
+        printf(" 0 ");
+    } else {
+        printf("%+d ", scores[tileIndex]);
+    }
+}
+
+// Draws the board, with the side-to-move's minimax value in every empty tile while the move values overlay is on.
 void DrawGameBoard(short posX, short posY) {
-    int index     = 0;
-    int tileIndex = 0;
+    int        index     = 0;
+    int        tileIndex = 0;
+    int        scores[BOARD_SIZE];
+    bool const isAnalyzed = gameData.toggleAnalysis && !gameData.isOver;
+    if (isAnalyzed) {
+        AnalyzeMoves(&analysisCache, gameData.board, gameData.currentPlayer, gameData.currentOpponent, scores);
+    }
     SetCursorPosition(
         posX,
         posY
@@ -363,7 +537,7 @@ void DrawGameBoard(short posX, short posY) {
         case '$':
             switch (boardLayout[++index]) {
             case 'c':
-                printf("%c", GetTileByPlayer(tileIndex++));
+                DrawGameBoardCell(tileIndex++, isAnalyzed ? scores : NULL);
                 break;
             case 'n':
                 printf("\n");
@@ -408,6 +582,15 @@ void EnqueueMessage(const char* pMessage) {
     gameData.messageCount++;
 }
 
+// Enqueues a copy of `message`, for text built in a buffer that is reused before the message leaves the queue.
+void EnqueueMessageCopy(const char* message) {
+    if (gameData.messageCount >= MESSAGE_COUNT_MAX) {
+        DequeueMessage();
+    }
+    (void)snprintf(gameData.messageText[gameData.messageTail], MESSAGE_TEXT_SIZE, "%s", message);
+    EnqueueMessage(gameData.messageText[gameData.messageTail]);
+}
+
 void DrawMessageBox(short posX, short posY) {
     SetCursorPosition(posX, posY);
     for (int i = 0; i < (int)gameData.messageCount; ++i) {
@@ -415,90 +598,38 @@ void DrawMessageBox(short posX, short posY) {
     }
 }
 
-static unsigned char sentenceHuman[] = "The previous player checked $.";
-static unsigned char sentenceAI[]    = "The computer checked $.";
-
-const char* GetPlayerCheckedMessage(PlayerType type, int checkTile) { // NOLINT
-    if (type == Player_Human) {
-        sentenceHuman[28] = checkTile < 10 ? (char)GetTileHintByTile(checkTile) : '?';
-        return (const char*)sentenceHuman;
-    }
-    sentenceAI[21] = checkTile < 10 ? (char)GetTileHintByTile(checkTile) : '?';
-    return (const char*)sentenceAI;
-}
-
-// clang-format off
-static const int winConditions[8][3] = {
-    {0, 1, 2},
-    {3, 4, 5},
-    {6, 7, 8},
-    {0, 3, 6},
-    {1, 4, 7},
-    {2, 5, 8},
-    {0, 4, 8},
-    {2, 4, 6}
-};
-// clang-format on
-
-int SatisfiesWinCondition(const int* winConditions, BoardTile player) {
-    return (gameData.board[winConditions[0]] == player && gameData.board[winConditions[1]] == player && gameData.board[winConditions[2]] == player);
-}
-
-int HasPlayerWonGame(BoardTile player, const int winConditions[8][3]) {
-    for (int i = 0; i < 8; ++i) {
-        if (SatisfiesWinCondition(winConditions[i], player)) {
-            return true;
-        }
-    }
-    return false;
-}
-
-static inline bool IsBoardFull() { return gameData.emptyTileCount < 1 ? true : false; }
-
-int Evaluate(BoardTile player, BoardTile opponent) {
-    if (HasPlayerWonGame(player, winConditions)) { return 1; }
-    if (HasPlayerWonGame(opponent, winConditions)) { return -1; }
-    if (IsBoardFull()) { return 0; }
-    return -2; // game is not over yet
-}
-
-int MinimaxRecursive(BoardTile player, BoardTile opponent, int depth, bool maximizingPlayer) { // NOLINT
-    int score = Evaluate(player, opponent);
-    if (score != -2 || depth == 0) { return score; }
-
-    int bestValue = 0;
-    if (maximizingPlayer) {
-        bestValue = INT_MIN;
-        for (int i = 0; i < BOARD_SIZE; ++i) {
-            if (gameData.board[i] == BoardTile_PlayerEmpty) {
-                gameData.board[i] = player;
-                int value         = MinimaxRecursive(player, opponent, depth - 1, false);
-                gameData.board[i] = BoardTile_PlayerEmpty;
-                bestValue         = max(bestValue, value);
-            }
-        }
+// Writes how the board of `variant` labels `tile`: its key on the classic board, otherwise its coordinates.
+void GetTileName(GameVariant variant, int tile, char* name, size_t size) {
+    if (variant == GameVariant_Qubic) {
+        (void)snprintf(name, size, "layer %d, %c%d", tile / QUBIC_LAYER_SIZE + 1, 'a' + tile % QUBIC_WIDTH, tile / QUBIC_WIDTH % QUBIC_WIDTH + 1);
+    } else if (variant == GameVariant_Ultimate) {
+        int const row = tile / ULTIMATE_BOARD_COUNT / ULTIMATE_WIDTH * ULTIMATE_WIDTH + tile % ULTIMATE_BOARD_COUNT / ULTIMATE_WIDTH;
+        int const col = tile / ULTIMATE_BOARD_COUNT % ULTIMATE_WIDTH * ULTIMATE_WIDTH + tile % ULTIMATE_WIDTH;
+        (void)snprintf(name, size, "%c%d", 'a' + col, row + 1);
     } else {
-        bestValue = INT_MAX;
-        for (int i = 0; i < BOARD_SIZE; ++i) {
-            if (gameData.board[i] == BoardTile_PlayerEmpty) {
-                gameData.board[i] = opponent;
-                int value         = MinimaxRecursive(opponent, player, depth - 1, true);
-                gameData.board[i] = BoardTile_PlayerEmpty;
-                bestValue         = min(bestValue, value);
-            }
-        }
+        (void)snprintf(name, size, "%c", tile < 10 ? GetTileHintByTile(tile) : '?');
     }
+}
 
-    return bestValue;
+void EnqueuePlayerCheckedMessage(PlayerType type, int checkTile) {
+    char name[16];
+    char message[MESSAGE_TEXT_SIZE];
+    GetTileName(gameData.variant, checkTile, name, sizeof(name));
+    (void)snprintf(message, sizeof(message), "%s checked %s.", type == Player_Human ? "The previous player" : "The computer", name);
+    EnqueueMessageCopy(message);
 }
 
 static inline int GetPlayerIndex(BoardTile player) { return player == BoardTile_PlayerOne ? 0 : 1; }
 
-void Game_Initialize(PlayerType player1, PlayerType player2) {
-    gameData.players[0] = player1;
-    gameData.players[1] = player2;
+void Game_Initialize(GameVariant variant, PlayerType player1, PlayerType player2, int aiDifficulty) {
+    gameData.players[0]   = player1;
+    gameData.players[1]   = player2;
+    gameData.variant      = variant;
+    gameData.tileCount    = variant == GameVariant_Qubic ? QUBIC_SIZE : (variant == GameVariant_Ultimate ? ULTIMATE_SIZE : BOARD_SIZE);
+    gameData.cursorTile   = variant == GameVariant_Ultimate ? ULTIMATE_SIZE / 2 : 0;
+    gameData.aiDifficulty = aiDifficulty;
 
-    for (int i = 0; i < BOARD_SIZE; ++i) {
+    for (int i = 0; i < GAME_TILE_COUNT_MAX; ++i) {
         gameData.board[i] = BoardTile_PlayerEmpty;
     }
 
@@ -506,15 +637,110 @@ void Game_Initialize(PlayerType player1, PlayerType player2) {
     gameData.currentOpponent    = BoardTile_PlayerTwo;
     gameData.currentPlayerIndex = 0;
     gameData.turnCount          = 2;
-    gameData.emptyTileCount     = BOARD_SIZE;
+    gameData.emptyTileCount     = gameData.tileCount;
     gameData.redraws            = false;
     gameData.isOver             = false;
     gameData.enqueuesAiMessage  = false;
+    gameData.moveCount          = 0;
+    gameData.moveRedoCount      = 0;
     ClearMessageQueue();
 
     EnqueueMessage(MESSAGE_SELECT_TILE);
 }
 
+static inline int Game_Evaluate() {
+    if (gameData.variant == GameVariant_Qubic) {
+        return Qubic_Evaluate(gameData.board, gameData.currentPlayer, gameData.currentOpponent);
+    }
+    if (gameData.variant == GameVariant_Ultimate) {
+        return Ultimate_Evaluate(gameData.board, gameData.currentPlayer, gameData.currentOpponent);
+    }
+    return Evaluate(gameData.board, gameData.currentPlayer, gameData.currentOpponent);
+}
+
+// Counts the tile just placed by the current player and either ends the game or passes the turn.
+// Returns whether the game goes on.
+static bool Game_ResolveTurn() {
+    gameData.emptyTileCount--;
+
+    int turnResult = Game_Evaluate();
+    if (turnResult == 1 || turnResult == -1) {
+        gameData.redraws = false;
+        gameData.isOver  = true;
+        EnqueueMessage("Congratulations! You won!\n");
+        return false;
+    }
+    if (turnResult == 0) {
+        gameData.redraws = false;
+        gameData.isOver  = true;
+        EnqueueMessage("It's a draw.");
+        return false;
+    }
+    swap(BoardTile, gameData.currentPlayer, gameData.currentOpponent);
+    gameData.turnCount++;
+    return true;
+}
+
+static inline int Game_GetLastMove() { return gameData.moveCount > 0 ? gameData.moveHistory[gameData.moveCount - 1] : -1; }
+
+// Puts the Ultimate cursor on the center of the sub-board the player to move is sent to.
+static void Game_FocusForcedBoard() {
+    if (gameData.variant != GameVariant_Ultimate) { return; }
+
+    UltimateState state;
+    Ultimate_FromTiles(gameData.board, gameData.currentPlayer, Game_GetLastMove(), &state);
+    if (state.forcedBoard >= 0) {
+        gameData.cursorTile = state.forcedBoard * ULTIMATE_BOARD_COUNT + ULTIMATE_BOARD_COUNT / 2;
+    }
+}
+
+static inline bool Game_IsHumanTurn() { return gameData.players[GetPlayerIndex(gameData.currentPlayer)] == Player_Human; }
+
+static inline bool Game_HasHumanPlayer() { return gameData.players[0] == Player_Human || gameData.players[1] == Player_Human; }
+
+// Takes back moves until it is a human's turn again, so the A.I. does not immediately replay.
+void Game_UndoMove() {
+    if (!Game_HasHumanPlayer()) { return; }
+
+    do {
+        if (gameData.moveCount < 1) { break; }
+        int tile             = gameData.moveHistory[--gameData.moveCount];
+        gameData.board[tile]  = BoardTile_PlayerEmpty;
+        gameData.emptyTileCount++;
+        if (gameData.isOver) {
+            gameData.isOver = false;
+        } else {
+            swap(BoardTile, gameData.currentPlayer, gameData.currentOpponent);
+            gameData.turnCount--;
+        }
+    } while (!Game_IsHumanTurn());
+
+    gameData.enqueuesAiMessage = false;
+    gameData.redraws           = false;
+    Game_FocusForcedBoard();
+    ClearMessageQueue();
+    EnqueueMessage(MESSAGE_SELECT_TILE);
+}
+
+// Replays undone moves until it is a human's turn again or the game ends.
+void Game_RedoMove() {
+    if (!Game_HasHumanPlayer()) { return; }
+
+    bool isPlaying   = !gameData.isOver;
+    gameData.redraws = false;
+    ClearMessageQueue();
+    while (isPlaying && gameData.moveCount < gameData.moveRedoCount) {
+        int tile             = gameData.moveHistory[gameData.moveCount++];
+        gameData.board[tile] = gameData.currentPlayer;
+        isPlaying            = Game_ResolveTurn() && !Game_IsHumanTurn();
+    }
+    gameData.enqueuesAiMessage = false;
+    Game_FocusForcedBoard();
+    if (!gameData.isOver) {
+        EnqueueMessage(MESSAGE_SELECT_TILE);
+    }
+}
+
 enum InputKey {
     KEY_NONE  = -1,
     KEY_0     = '0',
@@ -537,24 +763,21 @@ enum InputKey {
     KEY_X     = 'x',
     KEY_C     = 'c',
     KEY_H     = 'h',
+    KEY_M     = 'm',
+    KEY_U     = 'u',
+    KEY_Y     = 'y',
     KEY_ENTER = 13,
     KEY_SPACE = 32,
     KEY_ESC   = 27,
+    // arrow keys, as returned after their 0xE0 prefix
+    KEY_UP    = 72,
+    KEY_LEFT  = 75,
+    KEY_RIGHT = 77,
+    KEY_DOWN  = 80,
 };
 
-void Game_ProcessInput() {
-    inputKey = GetInputKey();
+static void Game_ProcessClassicInput() {
     switch (inputKey) {
-    case KEY_ENTER:
-    case KEY_SPACE:
-        if (!gameData.isOver) {
-            break;
-        }
-    case KEY_ESC:
-    case KEY_0:
-        currentScene = &sceneMenu;
-        Game_Finalize();
-        break;
     case KEY_1:
     case KEY_Q:
         inputKey = 1;
@@ -591,39 +814,120 @@ void Game_ProcessInput() {
     case KEY_C:
         inputKey = 9;
         break;
-    case KEY_H:
-        gameData.toggleTileHint = !gameData.toggleTileHint;
-        gameData.redraws        = false;
-        break;
     default:
         inputKey = KEY_NONE;
         break;
     }
 }
 
-int GetAIMove(int difficulty, BoardTile* board, BoardTile player, BoardTile opponent) {
-    int aiMove = 0;
+// Moves the cursor within a layer with WASD or the arrow keys, and between layers with Q/E.
+static void Game_ProcessQubicInput() {
+    int layer = gameData.cursorTile / QUBIC_LAYER_SIZE;
+    int row   = gameData.cursorTile / QUBIC_WIDTH % QUBIC_WIDTH;
+    int col   = gameData.cursorTile % QUBIC_WIDTH;
+    switch (inputKey) {
+    case KEY_W:
+    case KEY_UP:
+        row = (row + QUBIC_WIDTH - 1) % QUBIC_WIDTH;
+        break;
+    case KEY_S:
+    case KEY_DOWN:
+        row = (row + 1) % QUBIC_WIDTH;
+        break;
+    case KEY_A:
+    case KEY_LEFT:
+        col = (col + QUBIC_WIDTH - 1) % QUBIC_WIDTH;
+        break;
+    case KEY_D:
+    case KEY_RIGHT:
+        col = (col + 1) % QUBIC_WIDTH;
+        break;
+    case KEY_Q:
+        layer = (layer + QUBIC_WIDTH - 1) % QUBIC_WIDTH;
+        break;
+    case KEY_E:
+        layer = (layer + 1) % QUBIC_WIDTH;
+        break;
+    default:
+        inputKey = KEY_NONE;
+        return;
+    }
+    gameData.cursorTile = layer * QUBIC_LAYER_SIZE + row * QUBIC_WIDTH + col;
+    gameData.redraws    = false;
+    inputKey            = KEY_NONE;
+}
 
-    if (difficulty == 1) {
-        do {
-            aiMove = rand() % BOARD_SIZE; // NOLINT
-        } while (board[aiMove] != BoardTile_PlayerEmpty);
-        return aiMove;
+// Moves the cursor over the whole 9x9 grid with WASD or the arrow keys.
+static void Game_ProcessUltimateInput() {
+    int const width = ULTIMATE_WIDTH * ULTIMATE_WIDTH;
+    int       row   = gameData.cursorTile / ULTIMATE_BOARD_COUNT / ULTIMATE_WIDTH * ULTIMATE_WIDTH + gameData.cursorTile % ULTIMATE_BOARD_COUNT / ULTIMATE_WIDTH;
+    int       col   = gameData.cursorTile / ULTIMATE_BOARD_COUNT % ULTIMATE_WIDTH * ULTIMATE_WIDTH + gameData.cursorTile % ULTIMATE_WIDTH;
+    switch (inputKey) {
+    case KEY_W:
+    case KEY_UP:
+        row = (row + width - 1) % width;
+        break;
+    case KEY_S:
+    case KEY_DOWN:
+        row = (row + 1) % width;
+        break;
+    case KEY_A:
+    case KEY_LEFT:
+        col = (col + width - 1) % width;
+        break;
+    case KEY_D:
+    case KEY_RIGHT:
+        col = (col + 1) % width;
+        break;
+    default:
+        inputKey = KEY_NONE;
+        return;
     }
+    gameData.cursorTile = (row / ULTIMATE_WIDTH * ULTIMATE_WIDTH + col / ULTIMATE_WIDTH) * ULTIMATE_BOARD_COUNT + row % ULTIMATE_WIDTH * ULTIMATE_WIDTH + col % ULTIMATE_WIDTH;
+    gameData.redraws    = false;
+    inputKey            = KEY_NONE;
+}
 
-    int bestValue = INT_MIN;
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        if (board[i] == BoardTile_PlayerEmpty) {
-            board[i]         = player;
-            int currentValue = MinimaxRecursive(player, opponent, difficulty, true);
-            board[i]         = BoardTile_PlayerEmpty;
-            if (currentValue > bestValue) {
-                bestValue = currentValue;
-                aiMove    = i;
-            }
+void Game_ProcessInput() {
+    inputKey = GetInputKey();
+    switch (inputKey) {
+    case KEY_ENTER:
+    case KEY_SPACE:
+        if (!gameData.isOver) {
+            inputKey = gameData.variant != GameVariant_Classic ? gameData.cursorTile + 1 : KEY_NONE;
+            break;
+        }
+    case KEY_ESC:
+    case KEY_0:
+        currentScene = &sceneMenu;
+        Game_Finalize();
+        break;
+    case KEY_H:
+        gameData.toggleTileHint = !gameData.toggleTileHint;
+        gameData.redraws        = false;
+        break;
+    case KEY_M:
+        gameData.toggleAnalysis = !gameData.toggleAnalysis;
+        gameData.redraws        = false;
+        break;
+    case KEY_U:
+        Game_UndoMove();
+        inputKey = KEY_NONE;
+        break;
+    case KEY_Y:
+        Game_RedoMove();
+        inputKey = KEY_NONE;
+        break;
+    default:
+        if (gameData.variant == GameVariant_Qubic) {
+            Game_ProcessQubicInput();
+        } else if (gameData.variant == GameVariant_Ultimate) {
+            Game_ProcessUltimateInput();
+        } else {
+            Game_ProcessClassicInput();
         }
+        break;
     }
-    return aiMove;
 }
 
 // TODO(DevDasae) : Add New Game Mode
@@ -644,6 +948,10 @@ void Game_Update() {
             EnqueueMessage(MESSAGE_BoardTile_IS_NOT_EMPTY);
             return;
         }
+        if (gameData.variant == GameVariant_Ultimate && !Ultimate_IsLegalMove(gameData.board, Game_GetLastMove(), inputKey - 1)) {
+            EnqueueMessage(MESSAGE_SUB_BOARD_IS_NOT_OPEN);
+            return;
+        }
 
         gameData.board[inputKey - 1] = gameData.currentPlayer;
         ClearMessageQueue();
@@ -655,29 +963,26 @@ void Game_Update() {
             return;
         }
         gameData.enqueuesAiMessage = false;
-        int aiMove                 = GetAIMove(gameData.aiDifficulty, gameData.board, gameData.currentPlayer, gameData.currentOpponent);
-        gameData.board[aiMove]     = gameData.currentPlayer;
-        inputKey                   = aiMove + 1;
+        int aiMove                 = 0;
+        TRACE_SCOPE("GetAIMove") {
+            if (gameData.variant == GameVariant_Qubic) {
+                aiMove = Qubic_GetAIMove(gameData.aiDifficulty, gameData.board, gameData.currentPlayer, gameData.currentOpponent);
+            } else if (gameData.variant == GameVariant_Ultimate) {
+                aiMove = Ultimate_GetAIMove(gameData.aiDifficulty, gameData.board, gameData.currentPlayer, Game_GetLastMove());
+            } else {
+                aiMove = GetAIMove(gameData.aiDifficulty, gameData.board, gameData.currentPlayer, gameData.currentOpponent);
+            }
+        }
+        gameData.board[aiMove] = gameData.currentPlayer;
+        inputKey               = aiMove + 1;
     }
-    EnqueueMessage(GetPlayerCheckedMessage(gameData.players[gameData.currentPlayerIndex], inputKey - 1));
+    EnqueuePlayerCheckedMessage(gameData.players[gameData.currentPlayerIndex], inputKey - 1);
 
-    gameData.emptyTileCount--;
+    gameData.moveHistory[gameData.moveCount++] = inputKey - 1;
+    gameData.moveRedoCount                     = gameData.moveCount;
 
-    int turnResult = Evaluate(gameData.currentPlayer, gameData.currentOpponent);
-    if (turnResult == 1 || turnResult == -1) {
-        gameData.redraws = false;
-        gameData.isOver  = true;
-        EnqueueMessage("Congratulations! You won!\n");
-        return;
-    }
-    if (turnResult == 0) {
-        gameData.redraws = false;
-        gameData.isOver  = true;
-        EnqueueMessage("It's a draw.");
-        return;
-    }
-    swap(BoardTile, gameData.currentPlayer, gameData.currentOpponent);
-    gameData.turnCount++;
+    if (!Game_ResolveTurn()) { return; }
+    Game_FocusForcedBoard();
     if (isHumanTurn) {
         EnqueueMessage(MESSAGE_SELECT_TILE);
     }
@@ -685,23 +990,126 @@ void Game_Update() {
 
 
 
+// Draws the four layers side by side, bracketing the tile under the cursor.
+void DrawQubicBoard(short posX, short posY) {
+    for (int layer = 0; layer < QUBIC_WIDTH; ++layer) {
+        short const layerX = (short)(posX + layer * 16);
+        SetCursorPosition(layerX, posY);
+        printf("  Layer %d", layer + 1);
+        SetCursorPosition(layerX, posY + 1);
+        printf("   a  b  c  d");
+        for (int row = 0; row < QUBIC_WIDTH; ++row) {
+            SetCursorPosition(layerX, posY + 2 + row);
+            printf("%d ", row + 1);
+            for (int col = 0; col < QUBIC_WIDTH; ++col) {
+                int const  tileIndex = layer * QUBIC_LAYER_SIZE + row * QUBIC_WIDTH + col;
+                bool const isCursor  = tileIndex == gameData.cursorTile && !gameData.isOver;
+                char const tile      = gameData.board[tileIndex] == BoardTile_PlayerOne ? 'O' : (gameData.board[tileIndex] == BoardTile_PlayerTwo ? 'X' : '_');
+                printf("%c%c%c", isCursor ? '[' : ' ', tile, isCursor ? ']' : ' ');
+            }
+        }
+    }
+    SetCursorPosition(posX, posY + 2 + QUBIC_WIDTH);
+    printf("WASD/arrows: move, Q/E: layer, Enter: check");
+}
+
+// Draws the nine sub-boards as one 9x9 grid, and beside it the result of each sub-board,
+// with `*` on those the player to move may play in.
+void DrawUltimateBoard(short posX, short posY) {
+    UltimateState state;
+    Ultimate_FromTiles(gameData.board, gameData.currentPlayer, Game_GetLastMove(), &state);
+
+    SetCursorPosition(posX, posY);
+    printf("   a  b  c   d  e  f   g  h  i");
+    for (int row = 0; row < ULTIMATE_BOARD_COUNT; ++row) {
+        short const rowY = (short)(posY + 1 + row + row / ULTIMATE_WIDTH);
+        if (row > 0 && row % ULTIMATE_WIDTH == 0) {
+            SetCursorPosition(posX, rowY - 1);
+            printf("  ---------+---------+---------");
+        }
+        SetCursorPosition(posX, rowY);
+        printf("%d ", row + 1);
+        for (int col = 0; col < ULTIMATE_BOARD_COUNT; ++col) {
+            int const  tileIndex = (row / ULTIMATE_WIDTH * ULTIMATE_WIDTH + col / ULTIMATE_WIDTH) * ULTIMATE_BOARD_COUNT + row % ULTIMATE_WIDTH * ULTIMATE_WIDTH + col % ULTIMATE_WIDTH;
+            bool const isCursor  = tileIndex == gameData.cursorTile && !gameData.isOver;
+            char const tile      = gameData.board[tileIndex] == BoardTile_PlayerOne ? 'O' : (gameData.board[tileIndex] == BoardTile_PlayerTwo ? 'X' : '_');
+            if (col > 0 && col % ULTIMATE_WIDTH == 0) { printf("|"); }
+            printf("%c%c%c", isCursor ? '[' : ' ', tile, isCursor ? ']' : ' ');
+        }
+    }
+
+    SetCursorPosition((short)(posX + 34), posY);
+    printf("Boards");
+    for (int subBoard = 0; subBoard < ULTIMATE_BOARD_COUNT; ++subBoard) {
+        char status = '_';
+        if (state.won[0] >> subBoard & 1) {
+            status = 'O';
+        } else if (state.won[1] >> subBoard & 1) {
+            status = 'X';
+        } else if (state.decided >> subBoard & 1) {
+            status = '#';
+        } else if (!gameData.isOver && (state.forcedBoard < 0 || state.forcedBoard == subBoard)) {
+            status = '*';
+        }
+        SetCursorPosition((short)(posX + 34 + subBoard % ULTIMATE_WIDTH * 2), (short)(posY + 1 + subBoard / ULTIMATE_WIDTH));
+        printf("%c", status);
+    }
+    SetCursorPosition(posX, (short)(posY + 2 + ULTIMATE_BOARD_COUNT + ULTIMATE_WIDTH - 1));
+    printf("WASD/arrows: move, Enter: check");
+}
+
+void Game_PublishSpectatorFrame() {
+    const char* messages[MESSAGE_COUNT_MAX];
+    for (int i = 0; i < (int)gameData.messageCount; ++i) {
+        messages[i] = gameData.messageQueue[(gameData.messageHead + i) % MESSAGE_COUNT_MAX];
+    }
+    Spectator_Publish(gameData.variant, gameData.board, gameData.tileCount, gameData.turnCount, gameData.currentPlayer, gameData.isOver, messages, (int)gameData.messageCount);
+}
+
 void Game_Draw() {
     if (gameData.redraws) { return; }
+    isFrameBusy = true;
 
     DoSystemCls();
     ShowTurnsPlayer(0, 0);
     printf(" : Turn %d", gameData.turnCount / 2);
-    DrawGameBoard(0, 3);
-    DrawMessageBox(0, 9);
+    if (gameData.variant == GameVariant_Qubic) {
+        DrawQubicBoard(0, 3);
+        DrawMessageBox(0, 11);
+    } else if (gameData.variant == GameVariant_Ultimate) {
+        DrawUltimateBoard(0, 3);
+        DrawMessageBox(0, 17);
+    } else {
+        DrawGameBoard(0, 3);
+        DrawMessageBox(0, 9);
+    }
 
+    Game_PublishSpectatorFrame();
     gameData.redraws = true;
 }
 
+// Adds the result of a finished game to the statistics file, once, as the game is left.
+static void Game_RecordStatistics() {
+    if (!gameData.isOver) { return; }
+
+    int const       result      = Game_Evaluate();
+    StatsResult     statsResult = StatsResult_Draw;
+    StatsMode const mode        = !Game_HasHumanPlayer() ? StatsMode_AIVsAI : (gameData.players[0] == Player_AI || gameData.players[1] == Player_AI ? StatsMode_PlayerVsAI : StatsMode_PlayerVsPlayer);
+    if (result != 0) {
+        BoardTile const winner = result == 1 ? gameData.currentPlayer : gameData.currentOpponent;
+        statsResult            = winner == BoardTile_PlayerOne ? StatsResult_PlayerOneWon : StatsResult_PlayerTwoWon;
+    }
+    int const difficulty = mode == StatsMode_PlayerVsPlayer || gameData.aiDifficulty == 1 ? 0 : 1;
+    Stats_Record(gameData.variant, mode, difficulty, gameData.moveCount > 0 ? gameData.moveHistory[0] : -1, statsResult);
+}
+
 void Game_Finalize() {
+    Game_RecordStatistics();
+
     gameData.players[0] = Player_None;
     gameData.players[1] = Player_None;
 
-    for (int i = 0; i < BOARD_SIZE; ++i) {
+    for (int i = 0; i < GAME_TILE_COUNT_MAX; ++i) {
         gameData.board[i] = BoardTile_PlayerEmpty;
     }
 
@@ -713,6 +1121,8 @@ void Game_Finalize() {
     gameData.redraws            = false;
     gameData.isOver             = false;
     gameData.enqueuesAiMessage  = false;
+    gameData.moveCount          = 0;
+    gameData.moveRedoCount      = 0;
     ClearMessageQueue();
 }
 
@@ -742,6 +1152,7 @@ void Quit_Update() {
 
 void Quit_Draw() {
     if (quitData.redraws) { return; }
+    isFrameBusy = true;
     puts("Do you want to quit the game? (Y/n)");
     quitData.redraws = true;
 }
@@ -749,17 +1160,50 @@ void Quit_Draw() {
 int main(int argc, char const* argv[]) {
     (void)argc, (void)argv;
 
+    Engine_Initialize();
+    Qubic_Initialize();
+    Ultimate_Initialize();
+    Trace_Initialize(getenv("TIC_TAC_TOE_TRACE_FILE"));
+    const char* statsPath = getenv("TIC_TAC_TOE_STATS_FILE");
+    (void)Stats_Open(statsPath ? statsPath : "tic_tac_toe.stats");
+    const char* spectatorPath = getenv("TIC_TAC_TOE_SPECTATOR_FILE");
+    if (spectatorPath && !Spectator_Open(spectatorPath)) {
+        (void)fprintf(stderr, "Cannot map spectator feed %s\n", spectatorPath);
+    }
+    const char* scriptPath = getenv("TIC_TAC_TOE_SCRIPT_FILE");
+    if (scriptPath && !Headless_OpenScript(scriptPath)) {
+        (void)fprintf(stderr, "Cannot open input script %s\n", scriptPath);
+        return EXIT_FAILURE;
+    }
+    const char* nullOutput = getenv("TIC_TAC_TOE_NULL_OUTPUT");
+    if (nullOutput && strcmp(nullOutput, "0") != 0 && !Headless_OpenNullOutput()) {
+        (void)fprintf(stderr, "Cannot redirect output to %s\n", HEADLESS_NULL_DEVICE);
+    }
     SetCursorVisible(false);
     DoSystemCls();
 
     while (IsRunning()) {
-        currentScene->ProcessInput();
-        currentScene->Update();
-        currentScene->Draw();
+        size_t const traceMark = Trace_GetMark();
+        isFrameBusy            = false;
+        TRACE_SCOPE("Frame") {
+            HeadlessFrame frame = Headless_BeginFrame(currentScene->name);
+            TRACE_SCOPE("ProcessInput") { currentScene->ProcessInput(); }
+            Headless_EndPhase(&frame, HeadlessPhase_ProcessInput);
+            TRACE_SCOPE("Update") { currentScene->Update(); }
+            Headless_EndPhase(&frame, HeadlessPhase_Update);
+            TRACE_SCOPE("Draw") { currentScene->Draw(); }
+            Headless_EndPhase(&frame, HeadlessPhase_Draw);
+        }
+        // the loop polls the keyboard, so idle frames would otherwise fill the trace buffer within milliseconds
+        if (!isFrameBusy) { Trace_Rewind(traceMark); }
     }
 
     DoSystemCls();
-    DoSystemPause();
+    if (!Headless_IsScripted()) { DoSystemPause(); }
     SetCursorVisible(true);
+    (void)fflush(stdout);
+    Headless_Report(stderr);
+    Spectator_Close();
+    Stats_Close();
     return 0;
 }
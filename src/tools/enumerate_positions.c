@@ -0,0 +1,336 @@
+/**
+ * @file enumerate_positions.c
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Enumerates every reachable position and checks each engine variant against the reference minimax.
+    Build with -DBOARD_WIDTH=N -DBOARD_WIN_LENGTH=K to verify larger boards.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+// #region Header_Inclusion
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+#include "../engine.h"
+// #endregion // Header_Inclusion
+
+
+
+_Static_assert(BOARD_SIZE <= 40, "Positions are stored by their base-3 code within 64 bits");
+
+enum {
+    THREAD_COUNT_MAX     = 64,
+    POSITION_CHUNK_SIZE  = 64,
+    MISMATCH_SHOW_COUNT  = 8,
+    POSITION_SET_INITIAL = 1 << 12,
+};
+
+typedef struct EngineResult {
+    int value;
+    int move;
+} EngineResult;
+
+typedef struct EngineWorker EngineWorker;
+
+typedef struct EngineVariant {
+    const char* name;
+    EngineResult (*Search)(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent);
+} EngineVariant;
+
+static EngineResult SearchAnalysis(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent);
+static EngineResult SearchHeuristic(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent);
+static EngineResult SearchProof(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent);
+
+// Every variant must return the reference value from `player`'s point of view and one of its best moves.
+static const EngineVariant engineVariants[] = {
+    { "analysis", SearchAnalysis },
+    { "heuristic", SearchHeuristic },
+    { "proof", SearchProof },
+};
+enum { ENGINE_VARIANT_COUNT = sizeof(engineVariants) / sizeof(engineVariants[0]) };
+
+struct EngineWorker {
+    thrd_t         thread;
+    AnalysisCache* analysisCache;
+    ProofCache*    proofCache;
+    double         referenceSeconds;
+    double         variantSeconds[ENGINE_VARIANT_COUNT];
+    size_t         mismatches[ENGINE_VARIANT_COUNT];
+    size_t         verifiedCount;
+};
+
+typedef struct PositionSet {
+    unsigned long long* keys;
+    size_t              capacity;
+    size_t              count;
+} PositionSet;
+
+static PositionSet   positions;
+static size_t        terminalCount;
+static atomic_size_t nextPosition;
+static mtx_t         reportMutex;
+static size_t        reportedCount;
+static int           maxEmptyCount = BOARD_SIZE;
+
+static double GetSeconds() {
+    struct timespec now;
+    (void)timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+// #region Position_Set
+// Open addressing over (code + 1) so that zero marks a free slot.
+static bool PositionSet_Insert(PositionSet* set, unsigned long long code);
+
+static void PositionSet_Grow(PositionSet* set) {
+    unsigned long long* oldKeys     = set->keys;
+    size_t const        oldCapacity = set->capacity;
+
+    set->capacity = oldCapacity ? oldCapacity * 2 : POSITION_SET_INITIAL;
+    set->keys     = calloc(set->capacity, sizeof(*set->keys));
+    set->count    = 0;
+    if (!set->keys) {
+        (void)fprintf(stderr, "Out of memory growing the position set to %zu entries\n", set->capacity);
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < oldCapacity; ++i) {
+        if (oldKeys[i]) { (void)PositionSet_Insert(set, oldKeys[i] - 1); }
+    }
+    free(oldKeys);
+}
+
+static bool PositionSet_Insert(PositionSet* set, unsigned long long code) {
+    if ((set->count + 1) * 2 > set->capacity) { PositionSet_Grow(set); }
+
+    unsigned long long const key  = code + 1;
+    size_t                   slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 17) & (set->capacity - 1);
+    while (set->keys[slot]) {
+        if (set->keys[slot] == key) { return false; }
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+    set->keys[slot] = key;
+    set->count++;
+    return true;
+}
+
+// Packs the stored positions to the front of the table, in no particular order.
+static void PositionSet_Compact(PositionSet* set) {
+    size_t count = 0;
+    for (size_t i = 0; i < set->capacity; ++i) {
+        if (set->keys[i]) { set->keys[count++] = set->keys[i] - 1; }
+    }
+    set->count = count;
+}
+// #endregion // Position_Set
+
+static void DecodePosition(unsigned long long code, BoardTile* board, BoardTile* player, BoardTile* opponent) {
+    int balance = 0;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        int const digit = (int)(code % 3);
+        board[i]        = digit == 1 ? BoardTile_PlayerOne : (digit == 2 ? BoardTile_PlayerTwo : BoardTile_PlayerEmpty);
+        balance += board[i];
+        code /= 3;
+    }
+    *player   = balance == 0 ? BoardTile_PlayerOne : BoardTile_PlayerTwo;
+    *opponent = -*player;
+}
+
+static void EnumerateRecursive(BoardTile* board, BoardTile player, BoardTile opponent, unsigned long long code) { // NOLINT
+    if (!PositionSet_Insert(&positions, code)) { return; }
+    if (Evaluate(board, player, opponent) != -2) {
+        terminalCount++;
+        return;
+    }
+
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (board[i] != BoardTile_PlayerEmpty) { continue; }
+        board[i] = player;
+        EnumerateRecursive(board, opponent, player, code + GetAnalysisTileCode(player) * analysisTileWeights[i]);
+        board[i] = BoardTile_PlayerEmpty;
+    }
+}
+
+static EngineResult SearchAnalysis(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent) {
+    int scores[BOARD_SIZE];
+    AnalyzeMoves(worker->analysisCache, board, player, opponent, scores);
+
+    EngineResult result = { ANALYSIS_SCORE_NONE, -1 };
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (scores[i] != ANALYSIS_SCORE_NONE && scores[i] > result.value) {
+            result.value = scores[i];
+            result.move  = i;
+        }
+    }
+    return result;
+}
+
+static inline int GetProvenValue(int value) { return value > SCORE_PROVEN ? 1 : (value < -SCORE_PROVEN ? -1 : (value == 0 ? 0 : ANALYSIS_SCORE_NONE)); }
+
+// Searched to the end of the game, so every score must be a proven result.
+static EngineResult SearchHeuristic(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent) {
+    (void)worker;
+    int                value  = 0;
+    int const          move   = GetHeuristicMove(NULL, board, player, opponent, BOARD_SIZE, NULL, &value);
+    EngineResult const result = { GetProvenValue(value), move };
+    return result;
+}
+
+// The A.I. pipeline: threat-sequence proofs and refutations first, then the heuristic search to the end of the game.
+static EngineResult SearchProof(EngineWorker* worker, BoardTile* board, BoardTile player, BoardTile opponent) {
+    int                value  = 0;
+    int const          move   = GetProofMove(worker->proofCache, NULL, board, player, opponent, BOARD_SIZE, &value);
+    EngineResult const result = { GetProvenValue(value), move };
+    return result;
+}
+
+static void ReportMismatch(const char* name, const BoardTile* board, const int* referenceScores, int referenceValue, EngineResult result) {
+    (void)mtx_lock(&reportMutex);
+    if (reportedCount++ < MISMATCH_SHOW_COUNT) {
+        printf("Mismatch in %s: value %d move %d, reference value %d", name, result.value, result.move, referenceValue);
+        printf(" (move %d scores %d)\n", result.move, result.move >= 0 && result.move < BOARD_SIZE ? referenceScores[result.move] : ANALYSIS_SCORE_NONE);
+        for (int row = 0; row < BOARD_WIDTH; ++row) {
+            printf("    ");
+            for (int col = 0; col < BOARD_WIDTH; ++col) {
+                BoardTile const tile = board[row * BOARD_WIDTH + col];
+                printf("%c", tile == BoardTile_PlayerOne ? 'O' : (tile == BoardTile_PlayerTwo ? 'X' : '_'));
+            }
+            printf("\n");
+        }
+    }
+    (void)mtx_unlock(&reportMutex);
+}
+
+static void VerifyPosition(EngineWorker* worker, unsigned long long code) {
+    BoardTile board[BOARD_SIZE];
+    BoardTile player   = BoardTile_PlayerEmpty;
+    BoardTile opponent = BoardTile_PlayerEmpty;
+    DecodePosition(code, board, &player, &opponent);
+
+    int emptyCount = 0;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        emptyCount += board[i] == BoardTile_PlayerEmpty;
+    }
+    if (emptyCount > maxEmptyCount || Evaluate(board, player, opponent) != -2) { return; }
+
+    int    referenceScores[BOARD_SIZE];
+    int    referenceValue = INT_MIN;
+    double start          = GetSeconds();
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        referenceScores[i] = ANALYSIS_SCORE_NONE;
+        if (board[i] != BoardTile_PlayerEmpty) { continue; }
+        board[i]           = player;
+        referenceScores[i] = MinimaxRecursive(board, player, opponent, emptyCount - 1, false);
+        board[i]           = BoardTile_PlayerEmpty;
+        referenceValue     = max(referenceValue, referenceScores[i]);
+    }
+    worker->referenceSeconds += GetSeconds() - start;
+
+    for (int v = 0; v < ENGINE_VARIANT_COUNT; ++v) {
+        start                     = GetSeconds();
+        EngineResult const result = engineVariants[v].Search(worker, board, player, opponent);
+        worker->variantSeconds[v] += GetSeconds() - start;
+
+        bool const isLegal = result.move >= 0 && result.move < BOARD_SIZE && board[result.move] == BoardTile_PlayerEmpty;
+        if (result.value != referenceValue || !isLegal || referenceScores[result.move] != referenceValue) {
+            worker->mismatches[v]++;
+            ReportMismatch(engineVariants[v].name, board, referenceScores, referenceValue, result);
+        }
+    }
+    worker->verifiedCount++;
+}
+
+static int VerifyWorker(void* argument) {
+    EngineWorker* const worker = argument;
+    for (;;) {
+        size_t const begin = atomic_fetch_add(&nextPosition, POSITION_CHUNK_SIZE);
+        if (begin >= positions.count) { break; }
+        size_t const end = min(begin + POSITION_CHUNK_SIZE, positions.count);
+        for (size_t i = begin; i < end; ++i) {
+            VerifyPosition(worker, positions.keys[i]);
+        }
+    }
+    return 0;
+}
+
+static void PrintUsage(const char* program) {
+    printf("Usage: %s [--threads N] [--max-empty N]\n", program);
+    printf("  --threads N    worker threads (default 4, at most %d)\n", THREAD_COUNT_MAX);
+    printf("  --max-empty N  only verify positions with at most N empty tiles (default %d)\n", BOARD_SIZE);
+}
+
+int main(int argc, char const* argv[]) {
+    int threadCount = 4;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-empty") == 0 && i + 1 < argc) {
+            maxEmptyCount = atoi(argv[++i]);
+        } else {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    threadCount = max(1, min(threadCount, THREAD_COUNT_MAX));
+
+    Engine_Initialize();
+    (void)mtx_init(&reportMutex, mtx_plain);
+
+    double    start = GetSeconds();
+    BoardTile board[BOARD_SIZE];
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        board[i] = BoardTile_PlayerEmpty;
+    }
+    EnumerateRecursive(board, BoardTile_PlayerOne, BoardTile_PlayerTwo, 0);
+    PositionSet_Compact(&positions);
+    printf("Board %dx%d, %d in a row: %zu reachable positions (%zu terminal) enumerated in %.1f ms\n", BOARD_WIDTH, BOARD_WIDTH, BOARD_WIN_LENGTH, positions.count, terminalCount, (GetSeconds() - start) * 1e3);
+
+    static EngineWorker workers[THREAD_COUNT_MAX];
+    start = GetSeconds();
+    for (int t = 0; t < threadCount; ++t) {
+        workers[t].analysisCache = calloc(1, sizeof(AnalysisCache));
+        workers[t].proofCache    = calloc(1, sizeof(ProofCache));
+        if (!workers[t].analysisCache || !workers[t].proofCache || thrd_create(&workers[t].thread, VerifyWorker, &workers[t]) != thrd_success) {
+            (void)fprintf(stderr, "Failed to start worker %d\n", t);
+            return EXIT_FAILURE;
+        }
+    }
+
+    size_t verifiedCount                        = 0;
+    double referenceSeconds                     = 0;
+    double variantSeconds[ENGINE_VARIANT_COUNT] = { 0 };
+    size_t mismatches[ENGINE_VARIANT_COUNT]     = { 0 };
+    for (int t = 0; t < threadCount; ++t) {
+        (void)thrd_join(workers[t].thread, NULL);
+        verifiedCount += workers[t].verifiedCount;
+        referenceSeconds += workers[t].referenceSeconds;
+        for (int v = 0; v < ENGINE_VARIANT_COUNT; ++v) {
+            variantSeconds[v] += workers[t].variantSeconds[v];
+            mismatches[v] += workers[t].mismatches[v];
+        }
+        free(workers[t].analysisCache);
+        free(workers[t].proofCache);
+    }
+    printf("Verified %zu positions with at most %d empty tiles on %d threads in %.1f ms\n\n", verifiedCount, maxEmptyCount, threadCount, (GetSeconds() - start) * 1e3);
+
+    size_t const perPosition = max(verifiedCount, (size_t)1);
+    printf("%-12s %12s %12s %14s\n", "engine", "mismatches", "time (ms)", "us/position");
+    printf("%-12s %12s %12.1f %14.2f\n", "reference", "-", referenceSeconds * 1e3, referenceSeconds * 1e6 / (double)perPosition);
+    size_t totalMismatches = 0;
+    for (int v = 0; v < ENGINE_VARIANT_COUNT; ++v) {
+        printf("%-12s %12zu %12.1f %14.2f\n", engineVariants[v].name, mismatches[v], variantSeconds[v] * 1e3, variantSeconds[v] * 1e6 / (double)perPosition);
+        totalMismatches += mismatches[v];
+    }
+
+    free(positions.keys);
+    mtx_destroy(&reportMutex);
+    return totalMismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
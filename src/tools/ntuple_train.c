@@ -0,0 +1,410 @@
+/**
+ * @file ntuple_train.c
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Trains an N-tuple evaluation network by temporal-difference self-play, then matches it against the current engine.
+    Build with -DBOARD_WIDTH=N -DBOARD_WIN_LENGTH=K; a network only loads into builds for the same board.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+// #region Header_Inclusion
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "../ntuple.h"
+// #endregion // Header_Inclusion
+
+
+
+enum {
+    THREAD_COUNT_MAX      = 64,
+    ROUND_GAMES_DEFAULT   = 32,
+    TRAIN_GAMES_DEFAULT   = 100000,
+    MATCH_GAMES_DEFAULT   = 200,
+    MATCH_DEPTH_DEFAULT   = 2,
+    OPENING_PLIES_DEFAULT = 2,
+};
+
+typedef enum eGameResult {
+    GameResult_PlayerOneWon = 0,
+    GameResult_PlayerTwoWon,
+    GameResult_Draw,
+    GameResult_Count
+} GameResult;
+
+typedef struct TrainWorker {
+    thrd_t             thread;
+    unsigned long long seed;
+    float*             weights; // a private copy, merged back after every round
+    int                gameCount;
+    long long          results[GameResult_Count];
+    // match games: network results and time spent per side
+    ProofCache*        proofCache;
+    int                firstGame;
+    long long          networkResults[GameResult_Count]; // won, lost, drawn
+    double             networkSeconds;
+    double             engineSeconds;
+    long long          networkMoveCount;
+    long long          engineMoveCount;
+} TrainWorker;
+
+static float* sharedWeights;
+static float  learningRate    = 0.05f;
+static float  explorationRate = 0.05f;
+static int    matchDepth      = MATCH_DEPTH_DEFAULT;
+static int    openingPlies    = OPENING_PLIES_DEFAULT;
+static int    matchGameCount  = MATCH_GAMES_DEFAULT;
+
+static double GetSeconds() {
+    struct timespec now;
+    (void)timespec_get(&now, TIME_UTC);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static int GetProcessorCount() {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+static inline unsigned int GetRandom(unsigned long long* seed, unsigned int bound) {
+    return (unsigned int)((GetNextRandomKey(seed) >> 32) * bound >> 32);
+}
+
+static inline float GetRandomUnit(unsigned long long* seed) { return (float)(GetNextRandomKey(seed) >> 40) / (float)(1 << 24); }
+
+static bool IsWinningMove(const BoardTile* board, int cell, BoardTile player) {
+    for (int i = 0; i < cellWinConditionCounts[cell]; ++i) {
+        if (SatisfiesWinCondition(board, winConditions[cellWinConditions[cell][i]], player)) { return true; }
+    }
+    return false;
+}
+
+// #region Self_Play
+// Float counterpart of NTuple_Evaluate, in won-game units; padding offsets land on the trailing zero weight.
+static inline float GetNetworkValue(const float* weights, const NTupleState* state, int side) {
+    float sum = 0;
+    for (int t = 0; t < NTUPLE_INDEX_COUNT; ++t) {
+        sum += weights[state->offsets[side][t]];
+    }
+    return sum;
+}
+
+// The value of playing `cell` for `player`: 1 for a win, 0 for filling the board, otherwise the negated value
+// of the position the opponent is left with.
+static float GetMoveValue(const float* weights, BoardTile* board, NTupleState* state, int cell, BoardTile player, int emptyCount) {
+    board[cell] = player;
+    NTuple_Update(state, cell, player, true);
+    float const value = IsWinningMove(board, cell, player) ? 1.0f : (emptyCount == 1 ? 0.0f : -GetNetworkValue(weights, state, player == BoardTile_PlayerOne ? 1 : 0));
+    NTuple_Update(state, cell, player, false);
+    board[cell] = BoardTile_PlayerEmpty;
+    return value;
+}
+
+// Plays one epsilon-greedy game, moving each position's value towards that of the move played from it (TD(0)).
+static GameResult PlayTrainingGame(TrainWorker* worker) {
+    BoardTile   board[BOARD_SIZE] = { BoardTile_PlayerEmpty };
+    NTupleState state;
+    NTuple_Initialize(&state);
+
+    float const stepSize = learningRate / (float)NTUPLE_COUNT;
+    BoardTile   player   = BoardTile_PlayerOne;
+    BoardTile   opponent = BoardTile_PlayerTwo;
+    for (int emptyCount = BOARD_SIZE;; --emptyCount) {
+        int   move      = -1;
+        float moveValue = -INFINITY;
+        if (GetRandomUnit(&worker->seed) < explorationRate) {
+            unsigned int skip = GetRandom(&worker->seed, (unsigned int)emptyCount);
+            for (move = 0; board[move] != BoardTile_PlayerEmpty || skip-- > 0; ++move) { ; }
+            moveValue = GetMoveValue(worker->weights, board, &state, move, player, emptyCount);
+        } else {
+            for (int i = 0; i < BOARD_SIZE; ++i) {
+                if (board[i] != BoardTile_PlayerEmpty) { continue; }
+                float const value = GetMoveValue(worker->weights, board, &state, i, player, emptyCount);
+                if (value > moveValue) {
+                    moveValue = value;
+                    move      = i;
+                }
+            }
+        }
+
+        int const   side  = player == BoardTile_PlayerOne ? 0 : 1;
+        float const delta = stepSize * (moveValue - GetNetworkValue(worker->weights, &state, side));
+        for (int t = 0; t < NTUPLE_COUNT; ++t) {
+            worker->weights[state.offsets[side][t]] += delta;
+        }
+
+        board[move] = player;
+        NTuple_Update(&state, move, player, true);
+        if (IsWinningMove(board, move, player)) { return player == BoardTile_PlayerOne ? GameResult_PlayerOneWon : GameResult_PlayerTwoWon; }
+        if (emptyCount == 1) { return GameResult_Draw; }
+        swap(BoardTile, player, opponent);
+    }
+}
+
+static int TrainWorkerMain(void* argument) {
+    TrainWorker* const worker = argument;
+    memcpy(worker->weights, sharedWeights, sizeof(float) * (NTUPLE_WEIGHT_COUNT + 1));
+    for (int g = 0; g < worker->gameCount; ++g) {
+        worker->results[PlayTrainingGame(worker)]++;
+    }
+    return 0;
+}
+// #endregion // Self_Play
+
+// #region Match
+// Game `index` opens with `openingPlies` random moves shared with game `index ^ 1`, which swaps the colors.
+static GameResult PlayMatchGame(TrainWorker* worker, int index, bool* isNetworkPlayerOne) {
+    BoardTile board[BOARD_SIZE] = { BoardTile_PlayerEmpty };
+    BoardTile player            = BoardTile_PlayerOne;
+    BoardTile opponent          = BoardTile_PlayerTwo;
+    BoardTile networkPlayer     = index % 2 == 0 ? BoardTile_PlayerOne : BoardTile_PlayerTwo;
+    *isNetworkPlayerOne         = networkPlayer == BoardTile_PlayerOne;
+
+    unsigned long long openingSeed = 0x5851F42D4C957F2DULL + (unsigned long long)(index / 2);
+    for (int emptyCount = BOARD_SIZE, ply = 0;; --emptyCount, ++ply) {
+        int move = -1;
+        if (ply < openingPlies) {
+            unsigned int skip = GetRandom(&openingSeed, (unsigned int)emptyCount);
+            for (move = 0; board[move] != BoardTile_PlayerEmpty || skip-- > 0; ++move) { ; }
+        } else {
+            bool const   isNetwork = player == networkPlayer;
+            double const start     = GetSeconds();
+            int          value     = 0;
+            move                   = GetProofMove(worker->proofCache, isNetwork ? ntupleNetwork : NULL, board, player, opponent, matchDepth, &value);
+            double const seconds   = GetSeconds() - start;
+            if (isNetwork) {
+                worker->networkSeconds += seconds;
+                worker->networkMoveCount++;
+            } else {
+                worker->engineSeconds += seconds;
+                worker->engineMoveCount++;
+            }
+        }
+
+        board[move] = player;
+        if (IsWinningMove(board, move, player)) { return player == BoardTile_PlayerOne ? GameResult_PlayerOneWon : GameResult_PlayerTwoWon; }
+        if (emptyCount == 1) { return GameResult_Draw; }
+        swap(BoardTile, player, opponent);
+    }
+}
+
+static int MatchWorkerMain(void* argument) {
+    TrainWorker* const worker = argument;
+    for (int g = worker->firstGame; g < worker->firstGame + worker->gameCount; ++g) {
+        bool             isNetworkPlayerOne = false;
+        GameResult const result             = PlayMatchGame(worker, g, &isNetworkPlayerOne);
+        if (result == GameResult_Draw) {
+            worker->networkResults[GameResult_Draw]++;
+        } else {
+            bool const isNetworkWin = (result == GameResult_PlayerOneWon) == isNetworkPlayerOne;
+            worker->networkResults[isNetworkWin ? 0 : 1]++;
+        }
+        worker->results[result]++;
+    }
+    return 0;
+}
+// #endregion // Match
+
+static bool StartWorkers(TrainWorker* workers, int threadCount, thrd_start_t function) {
+    for (int t = 0; t < threadCount; ++t) {
+        if (thrd_create(&workers[t].thread, function, &workers[t]) != thrd_success) {
+            (void)fprintf(stderr, "Failed to start worker %d\n", t);
+            return false;
+        }
+    }
+    for (int t = 0; t < threadCount; ++t) {
+        (void)thrd_join(workers[t].thread, NULL);
+    }
+    return true;
+}
+
+// Every round each worker plays from the shared weights, and the sum of their changes is applied to them.
+static bool Train(TrainWorker* workers, int threadCount, int gameCount, int roundGameCount, const char* path) {
+    double const start                     = GetSeconds();
+    long long    results[GameResult_Count] = { 0 };
+    int          playedCount               = 0;
+    double       nextReport                = start + 1.0;
+    while (playedCount < gameCount) {
+        int const roundCount = min(gameCount - playedCount, roundGameCount * threadCount);
+        for (int t = 0; t < threadCount; ++t) {
+            workers[t].gameCount = roundCount / threadCount + (t < roundCount % threadCount);
+            memset(workers[t].results, 0, sizeof(workers[t].results));
+        }
+        if (!StartWorkers(workers, threadCount, TrainWorkerMain)) { return false; }
+
+        for (int i = 0; i < NTUPLE_WEIGHT_COUNT; ++i) {
+            float const base = sharedWeights[i];
+            float       sum  = base;
+            for (int t = 0; t < threadCount; ++t) {
+                sum += workers[t].weights[i] - base;
+            }
+            sharedWeights[i] = sum;
+        }
+        for (int t = 0; t < threadCount; ++t) {
+            for (int r = 0; r < GameResult_Count; ++r) {
+                results[r] += workers[t].results[r];
+            }
+        }
+        playedCount += roundCount;
+
+        double const now = GetSeconds();
+        if (now >= nextReport || playedCount == gameCount) {
+            long long const total = max(results[0] + results[1] + results[2], 1LL);
+            printf("%10d games  %8.0f games/s  first player won %5.1f%%, second %5.1f%%, drawn %5.1f%%\n", playedCount, playedCount / (now - start), 100.0 * results[0] / total, 100.0 * results[1] / total, 100.0 * results[2] / total);
+            memset(results, 0, sizeof(results));
+            nextReport = now + 1.0;
+        }
+    }
+
+    for (int i = 0; i < NTUPLE_WEIGHT_COUNT; ++i) {
+        ntupleNetwork[i] = NTuple_Quantize(sharedWeights[i]);
+    }
+    if (!NTuple_Save(path, ntupleNetwork)) {
+        (void)fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    printf("Saved %d weights (%zu bytes) to %s\n\n", NTUPLE_WEIGHT_COUNT, sizeof(NTupleFileHeader) + sizeof(short) * NTUPLE_WEIGHT_COUNT, path);
+    return true;
+}
+
+static bool Match(TrainWorker* workers, int threadCount) {
+    double const start = GetSeconds();
+    int          first = 0;
+    for (int t = 0; t < threadCount; ++t) {
+        workers[t].firstGame = first;
+        workers[t].gameCount = matchGameCount / threadCount + (t < matchGameCount % threadCount);
+        first += workers[t].gameCount;
+        memset(workers[t].results, 0, sizeof(workers[t].results));
+    }
+    if (!StartWorkers(workers, threadCount, MatchWorkerMain)) { return false; }
+
+    long long results[GameResult_Count]        = { 0 };
+    long long networkResults[GameResult_Count] = { 0 };
+    double    networkSeconds                   = 0;
+    double    engineSeconds                    = 0;
+    long long networkMoveCount                 = 0;
+    long long engineMoveCount                  = 0;
+    for (int t = 0; t < threadCount; ++t) {
+        for (int r = 0; r < GameResult_Count; ++r) {
+            results[r] += workers[t].results[r];
+            networkResults[r] += workers[t].networkResults[r];
+        }
+        networkSeconds += workers[t].networkSeconds;
+        engineSeconds += workers[t].engineSeconds;
+        networkMoveCount += workers[t].networkMoveCount;
+        engineMoveCount += workers[t].engineMoveCount;
+    }
+
+    double const score = (networkResults[0] + 0.5 * networkResults[GameResult_Draw]) / max(matchGameCount, 1);
+    printf("Network vs engine at depth %d, %d games from %d-ply random openings in %.1f s\n", matchDepth, matchGameCount, openingPlies, GetSeconds() - start);
+    printf("  network won %lld, lost %lld, drew %lld: score %.1f%%", networkResults[0], networkResults[1], networkResults[GameResult_Draw], 100.0 * score);
+    if (score > 0 && score < 1) { printf(" (%+.0f Elo)", -400.0 * log10(1.0 / score - 1.0)); }
+    printf("\n  first player won %lld, second %lld, drawn %lld\n", results[0], results[1], results[GameResult_Draw]);
+    printf("  %.3f ms per network move, %.3f ms per engine move\n", networkSeconds * 1e3 / (double)max(networkMoveCount, 1LL), engineSeconds * 1e3 / (double)max(engineMoveCount, 1LL));
+    return true;
+}
+
+static void PrintUsage(const char* program) {
+    printf("Usage: %s [--threads N] [--games N] [--round N] [--alpha A] [--epsilon E] [--match N] [--depth N] [--opening N] FILE\n", program);
+    printf("  --threads N  worker threads (default: one per processor, at most %d)\n", THREAD_COUNT_MAX);
+    printf("  --games N    self-play training games written to FILE; 0 loads FILE instead (default %d)\n", TRAIN_GAMES_DEFAULT);
+    printf("  --round N    games per worker between weight merges (default %d)\n", ROUND_GAMES_DEFAULT);
+    printf("  --alpha A    learning rate, shared out over the tuples (default %.2f)\n", learningRate);
+    printf("  --epsilon E  share of random moves in self-play (default %.2f)\n", explorationRate);
+    printf("  --match N    games against the current engine, half with each color (default %d)\n", MATCH_GAMES_DEFAULT);
+    printf("  --depth N    search depth of both sides in the match (default %d)\n", MATCH_DEPTH_DEFAULT);
+    printf("  --opening N  random plies opening each pair of match games (default %d)\n", OPENING_PLIES_DEFAULT);
+}
+
+int main(int argc, char const* argv[]) {
+    const char* path           = NULL;
+    int         threadCount    = GetProcessorCount();
+    int         gameCount      = TRAIN_GAMES_DEFAULT;
+    int         roundGameCount = ROUND_GAMES_DEFAULT;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            gameCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--round") == 0 && i + 1 < argc) {
+            roundGameCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+            learningRate = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--epsilon") == 0 && i + 1 < argc) {
+            explorationRate = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--match") == 0 && i + 1 < argc) {
+            matchGameCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            matchDepth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--opening") == 0 && i + 1 < argc) {
+            openingPlies = atoi(argv[++i]);
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (!path) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    threadCount    = max(1, min(threadCount, THREAD_COUNT_MAX));
+    gameCount      = max(0, gameCount);
+    roundGameCount = max(1, roundGameCount);
+    matchGameCount = max(0, matchGameCount);
+    matchDepth     = max(1, matchDepth);
+    openingPlies   = max(0, min(openingPlies, BOARD_SIZE - 1));
+
+    Engine_Initialize();
+    printf("Board %dx%d, %d in a row: %d tuples of %d tiles, %d weights, %d threads\n", BOARD_WIDTH, BOARD_WIDTH, BOARD_WIN_LENGTH, NTUPLE_COUNT, NTUPLE_LENGTH, NTUPLE_WEIGHT_COUNT, threadCount);
+
+    // one weight past the tables stays zero for the padding offsets
+    sharedWeights = calloc(NTUPLE_WEIGHT_COUNT + 1, sizeof(float));
+    bool isDone   = sharedWeights != NULL;
+    static TrainWorker workers[THREAD_COUNT_MAX];
+    for (int t = 0; t < threadCount; ++t) {
+        workers[t].seed       = 0x9E3779B97F4A7C15ULL * (unsigned long long)(t + 1);
+        workers[t].weights    = calloc(NTUPLE_WEIGHT_COUNT + 1, sizeof(float));
+        workers[t].proofCache = calloc(1, sizeof(ProofCache));
+        isDone                = isDone && workers[t].weights && workers[t].proofCache;
+    }
+
+    if (!isDone) {
+        (void)fprintf(stderr, "Out of memory allocating %d weights per thread\n", NTUPLE_WEIGHT_COUNT);
+    } else if (gameCount > 0) {
+        isDone = Train(workers, threadCount, gameCount, roundGameCount, path);
+    } else if (!(isDone = NTuple_Load(path, ntupleNetwork))) {
+        (void)fprintf(stderr, "Cannot load a %dx%d, %d in a row network from %s\n", BOARD_WIDTH, BOARD_WIDTH, BOARD_WIN_LENGTH, path);
+    }
+    if (isDone && matchGameCount > 0) { isDone = Match(workers, threadCount); }
+
+    for (int t = 0; t < threadCount; ++t) {
+        free(workers[t].weights);
+        free(workers[t].proofCache);
+    }
+    free(sharedWeights);
+    return isDone ? EXIT_SUCCESS : EXIT_FAILURE;
+}
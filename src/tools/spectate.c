@@ -0,0 +1,169 @@
+/**
+ * @file spectate.c
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Tails the spectator feed of a running game and prints every frame it publishes.
+    Start the game with TIC_TAC_TOE_SPECTATOR_FILE set to the same path.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+// #region Header_Inclusion
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+#include "../qubic.h"
+#include "../spectator.h"
+#include "../ultimate.h"
+// #endregion // Header_Inclusion
+
+
+
+enum {
+    FRAME_TEXT_SIZE = 4096,
+    POLL_DEFAULT_MS = 20,
+};
+
+static inline char GetTileChar(signed char tile) { return tile > 0 ? 'O' : (tile < 0 ? 'X' : '_'); }
+
+static int AppendText(char* text, int length, const char* format, ...) {
+    if (length >= FRAME_TEXT_SIZE) { return length; }
+    va_list args;
+    va_start(args, format);
+    int const written = vsnprintf(text + length, (size_t)(FRAME_TEXT_SIZE - length), format, args);
+    va_end(args);
+    return written < 0 ? length : min(length + written, FRAME_TEXT_SIZE - 1);
+}
+
+// Formats the frame straight out of the mapping; the caller discards the text if the frame was torn meanwhile.
+static int FormatFrame(const SpectatorFrame* frame, unsigned long long number, char* text) {
+    int length = 0;
+    length     = AppendText(text, length, "#%llu turn %d, %c to move%s\n", number, frame->turnCount / 2, GetTileChar(frame->currentPlayer), frame->isOver ? " (game over)" : "");
+
+    int const tileCount = min(max(frame->tileCount, 0), SPECTATOR_TILE_COUNT_MAX);
+    if (frame->variant == SpectatorVariant_Qubic && tileCount == QUBIC_SIZE) {
+        // the four Qubic layers side by side
+        for (int row = 0; row < QUBIC_WIDTH; ++row) {
+            for (int layer = 0; layer < QUBIC_WIDTH; ++layer) {
+                for (int column = 0; column < QUBIC_WIDTH; ++column) {
+                    length = AppendText(text, length, " %c", GetTileChar(frame->board[layer * QUBIC_LAYER_SIZE + row * QUBIC_WIDTH + column]));
+                }
+                length = AppendText(text, length, "  ");
+            }
+            length = AppendText(text, length, "\n");
+        }
+    } else if (frame->variant == SpectatorVariant_Ultimate && tileCount == ULTIMATE_SIZE) {
+        // Ultimate tiles are stored sub-board by sub-board
+        for (int row = 0; row < ULTIMATE_BOARD_COUNT; ++row) {
+            for (int column = 0; column < ULTIMATE_BOARD_COUNT; ++column) {
+                int const tile = (row / ULTIMATE_WIDTH * ULTIMATE_WIDTH + column / ULTIMATE_WIDTH) * ULTIMATE_BOARD_COUNT + row % ULTIMATE_WIDTH * ULTIMATE_WIDTH + column % ULTIMATE_WIDTH;
+                length         = AppendText(text, length, "%s %c", column > 0 && column % ULTIMATE_WIDTH == 0 ? " |" : "", GetTileChar(frame->board[tile]));
+            }
+            length = AppendText(text, length, "\n");
+        }
+    } else {
+        int width = 1;
+        while (width * width < tileCount) { ++width; }
+        for (int row = 0; row < width; ++row) {
+            for (int column = 0; column < width && row * width + column < tileCount; ++column) {
+                length = AppendText(text, length, " %c", GetTileChar(frame->board[row * width + column]));
+            }
+            length = AppendText(text, length, "\n");
+        }
+    }
+
+    int const messageCount = min(max(frame->messageCount, 0), SPECTATOR_MESSAGE_COUNT);
+    for (int i = 0; i < messageCount; ++i) {
+        length = AppendText(text, length, "  %.*s\n", SPECTATOR_MESSAGE_LENGTH, frame->messages[i]);
+    }
+    return length;
+}
+
+static void SleepMS(int milliseconds) {
+    struct timespec duration = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000L };
+    (void)thrd_sleep(&duration, NULL);
+}
+
+static void PrintUsage(const char* program) {
+    printf("Usage: %s [--from-start] [--poll MS] FILE\n", program);
+    printf("  --from-start  also print the frames still held in the ring (default: only new ones)\n");
+    printf("  --poll MS     delay between checks for new frames (default %d)\n", POLL_DEFAULT_MS);
+}
+
+int main(int argc, char const* argv[]) {
+    const char* path        = NULL;
+    bool        isFromStart = false;
+    int         pollMS      = POLL_DEFAULT_MS;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--from-start") == 0) {
+            isFromStart = true;
+        } else if (strcmp(argv[i], "--poll") == 0 && i + 1 < argc) {
+            pollMS = atoi(argv[++i]);
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            PrintUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    pollMS = max(1, pollMS);
+    if (!path) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    MappedFile     mapping;
+    SpectatorFeed* feed = NULL;
+    while (!(feed = MappedFile_Open(&mapping, path, sizeof(SpectatorFeed), MappedFile_ReadOnly, NULL))) { SleepMS(pollMS); }
+    while (!Spectator_IsValid(feed)) { SleepMS(pollMS); }
+
+    unsigned int       generation = Spectator_GetGeneration(feed);
+    unsigned long long last       = Spectator_GetHead(feed);
+    if (isFromStart) { last = last > SPECTATOR_SLOT_COUNT ? last - SPECTATOR_SLOT_COUNT : 0; }
+
+    static char text[FRAME_TEXT_SIZE];
+    for (;;) {
+        // a game that reopens the feed invalidates it while resetting it, then bumps the generation
+        if (!Spectator_IsValid(feed)) {
+            (void)fflush(stdout);
+            SleepMS(pollMS);
+            continue;
+        }
+        unsigned long long const head = Spectator_GetHead(feed);
+        if (Spectator_GetGeneration(feed) != generation) {
+            printf("-- feed restarted --\n");
+            generation = Spectator_GetGeneration(feed);
+            last       = 0;
+            continue;
+        }
+        if (head == last) {
+            (void)fflush(stdout);
+            SleepMS(pollMS);
+            continue;
+        }
+        if (head - last > SPECTATOR_SLOT_COUNT - 1) {
+            // keep one slot of headroom for the frame being written
+            unsigned long long const next = head - (SPECTATOR_SLOT_COUNT - 1);
+            printf("-- skipped %llu frames --\n", next - last - 1);
+            last = next - 1;
+        }
+
+        unsigned long long const number = last + 1;
+        const SpectatorFrame*    frame  = Spectator_BeginRead(feed, number);
+        int const                length = frame ? FormatFrame(frame, number, text) : 0;
+        if (frame && Spectator_EndRead(frame, number) && Spectator_GetGeneration(feed) == generation) {
+            (void)fwrite(text, 1, (size_t)length, stdout);
+        } else {
+            printf("-- skipped frame %llu --\n", number);
+        }
+        last = number;
+    }
+}
@@ -0,0 +1,188 @@
+/**
+ * @file trace.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Scoped trace markers written as a Chrome trace-event JSON file (open it in Perfetto or chrome://tracing).
+    Compiled out unless TIC_TAC_TOE_TRACE is defined.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_TRACE_H
+#define TIC_TAC_TOE_TRACE_H
+
+#if defined(TIC_TAC_TOE_TRACE)
+
+// #region Header_Inclusion
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+// #endregion // Header_Inclusion
+
+enum {
+    TRACE_EVENT_CAPACITY = 1 << 16,
+    TRACE_ARG_NONE       = -1,
+};
+
+typedef struct TraceEvent {
+    const char* name;
+    long long   startNS;
+    long long   durationNS;
+    int         arg;
+} TraceEvent;
+
+// Each thread appends to its own buffer without locking; buffers are only linked into the global list
+// (with a compare-and-swap) when a thread records its first event, and are read once at exit.
+// The buffer is a ring: event `i` lives in slot i % TRACE_EVENT_CAPACITY, and once it is full the newest
+// events overwrite the oldest, so events [first, count) are the ones still held.
+typedef struct TraceBuffer TraceBuffer;
+struct TraceBuffer {
+    TraceBuffer* next;
+    int          threadId;
+    size_t       first;
+    size_t       count;
+    TraceEvent   events[];
+};
+
+typedef struct TraceScope {
+    const char* name;
+    long long   startNS;
+    int         arg;
+} TraceScope;
+
+static _Atomic(TraceBuffer*) traceBuffers;
+static atomic_int            traceThreadCount;
+static _Thread_local TraceBuffer* traceThreadBuffer;
+static const char*           traceFilePath = "trace.json";
+static long long             traceStartNS;
+
+// Reads a monotonic clock, so wall-clock adjustments never reorder or stretch events.
+static inline long long Trace_GetTimeNS() {
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    (void)QueryPerformanceCounter(&counter);
+    (void)QueryPerformanceFrequency(&frequency);
+    return counter.QuadPart / frequency.QuadPart * 1000000000LL + counter.QuadPart % frequency.QuadPart * 1000000000LL / frequency.QuadPart;
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+static inline TraceBuffer* Trace_GetThreadBuffer() {
+    if (traceThreadBuffer) { return traceThreadBuffer; }
+
+    TraceBuffer* buffer = calloc(1, sizeof(TraceBuffer) + TRACE_EVENT_CAPACITY * sizeof(TraceEvent));
+    if (!buffer) { return NULL; }
+    buffer->threadId = atomic_fetch_add(&traceThreadCount, 1) + 1;
+    buffer->next     = atomic_load(&traceBuffers);
+    while (!atomic_compare_exchange_weak(&traceBuffers, &buffer->next, buffer)) { ; }
+    traceThreadBuffer = buffer;
+    return buffer;
+}
+
+static inline TraceScope Trace_Begin(const char* name, int arg) {
+    TraceScope scope = { name, Trace_GetTimeNS(), arg };
+    return scope;
+}
+
+static inline void Trace_End(TraceScope* scope) {
+    long long const endNS  = Trace_GetTimeNS();
+    TraceBuffer*    buffer = Trace_GetThreadBuffer();
+    if (buffer) {
+        TraceEvent* event = &buffer->events[buffer->count % TRACE_EVENT_CAPACITY];
+        event->name       = scope->name;
+        event->startNS    = scope->startNS;
+        event->durationNS = endNS - scope->startNS;
+        event->arg        = scope->arg;
+        buffer->count++;
+        if (buffer->count - buffer->first > TRACE_EVENT_CAPACITY) { buffer->first = buffer->count - TRACE_EVENT_CAPACITY; }
+    }
+    scope->name = NULL;
+}
+
+// Returns a mark for Trace_Rewind() covering the calling thread's events recorded from now on.
+static inline size_t Trace_GetMark() {
+    TraceBuffer* buffer = Trace_GetThreadBuffer();
+    return buffer ? buffer->count : 0;
+}
+
+// Discards the calling thread's events recorded since `mark`, e.g. those of a frame that did nothing.
+// Older events they already overwrote stay lost.
+static inline void Trace_Rewind(size_t mark) {
+    TraceBuffer* buffer = Trace_GetThreadBuffer();
+    if (!buffer || mark > buffer->count) { return; }
+    buffer->count = mark;
+    if (buffer->first > mark) { buffer->first = mark; }
+}
+
+// Writes every thread's events, timed from Trace_Initialize(), and frees the buffers. Registered with atexit()
+// by Trace_Initialize(); threads that are still recording at that point must have been joined.
+static inline void Trace_Flush() {
+    FILE* file = fopen(traceFilePath, "w");
+    if (!file) {
+        (void)fprintf(stderr, "Cannot write trace file %s\n", traceFilePath);
+        return;
+    }
+
+    TraceBuffer* buffer = atomic_exchange(&traceBuffers, NULL);
+    bool         first  = true;
+    (void)fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    while (buffer) {
+        (void)fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", first ? "" : ",", buffer->threadId, buffer->threadId);
+        first = false;
+        for (size_t i = buffer->first; i < buffer->count; ++i) {
+            TraceEvent const* event = &buffer->events[i % TRACE_EVENT_CAPACITY];
+            (void)fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f", event->name, buffer->threadId, (double)(event->startNS - traceStartNS) * 1e-3, (double)event->durationNS * 1e-3);
+            if (event->arg != TRACE_ARG_NONE) { (void)fprintf(file, ",\"args\":{\"tile\":%d}", event->arg); }
+            (void)fprintf(file, "}");
+        }
+        if (buffer->first) {
+            (void)fprintf(stderr, "Trace buffer of thread %d was full; the oldest %zu events were overwritten\n", buffer->threadId, buffer->first);
+        }
+        TraceBuffer* next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+    (void)fprintf(file, "\n]}\n");
+    (void)fclose(file);
+}
+
+static inline void Trace_Initialize(const char* path) {
+    if (path) { traceFilePath = path; }
+    traceStartNS = Trace_GetTimeNS();
+    (void)atexit(Trace_Flush);
+}
+
+// Times the statement or block that follows it, e.g. `TRACE_SCOPE("Draw") { Draw(); }`.
+// The block is the body of a hidden `for` loop, so `break` and `continue` inside it never reach an enclosing
+// loop or switch: `continue` only ends the scope (the event is recorded), while `break`, return and goto
+// leave it without recording the event.
+#define TRACE_SCOPE(_name)          TRACE_SCOPE_ARG(_name, TRACE_ARG_NONE)
+#define TRACE_SCOPE_ARG(_name, _arg) for (TraceScope __traceScope = Trace_Begin(_name, _arg); __traceScope.name; Trace_End(&__traceScope))
+
+#else // !defined(TIC_TAC_TOE_TRACE)
+
+#define Trace_Initialize(_path)      ((void)(_path))
+#define Trace_GetMark()              ((size_t)0)
+#define Trace_Rewind(_mark)          ((void)(_mark))
+#define TRACE_SCOPE(_name)
+#define TRACE_SCOPE_ARG(_name, _arg)
+
+#endif // defined(TIC_TAC_TOE_TRACE)
+
+#endif // TIC_TAC_TOE_TRACE_H
@@ -0,0 +1,304 @@
+/**
+ * @file ultimate.h
+ * @author Gyeongtae Kim(dev-dasae) <codingpelican@gmail.com>
+ *
+ * @brief Ultimate tic-tac-toe engine on per-sub-board 9-bit masks.
+    Tile index is subBoard * 9 + cell; the cell just played picks the sub-board the opponent must play in.
+ *
+ * @version 0.2
+ * @date 2024-04-07
+ *
+ * @copyright Released under the MIT License. See LICENSE file for details.
+ */
+
+
+#ifndef TIC_TAC_TOE_ULTIMATE_H
+#define TIC_TAC_TOE_ULTIMATE_H
+
+// #region Header_Inclusion
+#include <limits.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "engine.h"
+#include "search.h"
+// #endregion // Header_Inclusion
+
+enum {
+    ULTIMATE_WIDTH          = 3,
+    ULTIMATE_BOARD_COUNT    = ULTIMATE_WIDTH * ULTIMATE_WIDTH,
+    ULTIMATE_SIZE           = ULTIMATE_BOARD_COUNT * ULTIMATE_BOARD_COUNT,
+    ULTIMATE_MASK_FULL      = (1 << ULTIMATE_BOARD_COUNT) - 1,
+    ULTIMATE_LINE_COUNT     = 8,
+    ULTIMATE_DEPTH_MAX      = 64,
+    ULTIMATE_TIME_BUDGET_MS = 400,
+    ULTIMATE_CACHE_SIZE     = 1 << 18,
+};
+
+typedef unsigned long long UltimateKey;
+
+// Players are indexed absolutely (0 = BoardTile_PlayerOne). `won` and `decided` cache each sub-board's
+// status so that it is looked up once per move instead of rescanning the cells.
+typedef struct UltimateState {
+    unsigned short cells[2][ULTIMATE_BOARD_COUNT];
+    unsigned short won[2];
+    unsigned short decided; // won by either player or full
+    signed char    forcedBoard; // -1 when any undecided sub-board may be played
+    unsigned char  side;
+    UltimateKey    key;
+} UltimateState;
+
+static unsigned short ultimateLineMasks[ULTIMATE_LINE_COUNT];
+// Whether a 9-bit mask holds a line; shared by all sub-boards and the board of sub-board results.
+static bool           ultimateWinTable[1 << ULTIMATE_BOARD_COUNT];
+static UltimateKey    ultimateTileKeys[2][ULTIMATE_SIZE];
+static UltimateKey    ultimateForcedKeys[ULTIMATE_BOARD_COUNT + 1];
+static UltimateKey    ultimateSideKey;
+
+static inline void Ultimate_Initialize() {
+    for (int i = 0; i < ULTIMATE_WIDTH; ++i) {
+        ultimateLineMasks[i]                  = (unsigned short)(0x7 << (i * ULTIMATE_WIDTH));
+        ultimateLineMasks[ULTIMATE_WIDTH + i] = (unsigned short)(0x49 << i);
+    }
+    ultimateLineMasks[6] = 0x111;
+    ultimateLineMasks[7] = 0x054;
+
+    for (int mask = 0; mask <= ULTIMATE_MASK_FULL; ++mask) {
+        for (int i = 0; i < ULTIMATE_LINE_COUNT && !ultimateWinTable[mask]; ++i) {
+            ultimateWinTable[mask] = (mask & ultimateLineMasks[i]) == ultimateLineMasks[i];
+        }
+    }
+
+    UltimateKey seed = 0x5DEECE66DULL;
+    for (int side = 0; side < 2; ++side) {
+        for (int i = 0; i < ULTIMATE_SIZE; ++i) {
+            ultimateTileKeys[side][i] = GetNextRandomKey(&seed);
+        }
+    }
+    for (int i = 0; i <= ULTIMATE_BOARD_COUNT; ++i) {
+        ultimateForcedKeys[i] = GetNextRandomKey(&seed);
+    }
+    ultimateSideKey = GetNextRandomKey(&seed);
+}
+
+static inline int Ultimate_CountBits(unsigned int bits) { return __builtin_popcount(bits); }
+
+// Empty cells of a sub-board that would complete one of `mine`'s lines.
+static inline unsigned int Ultimate_GetThreats(unsigned int mine, unsigned int theirs) {
+    unsigned int threats = 0;
+    for (int i = 0; i < ULTIMATE_LINE_COUNT; ++i) {
+        unsigned int const line = ultimateLineMasks[i];
+        if (!(line & theirs) && Ultimate_CountBits(line & mine) == ULTIMATE_WIDTH - 1) {
+            threats |= line & ~mine;
+        }
+    }
+    return threats;
+}
+
+static inline void Ultimate_Play(UltimateState* state, int tile) {
+    int const side     = state->side;
+    int const subBoard = tile / ULTIMATE_BOARD_COUNT;
+    int const cell     = tile % ULTIMATE_BOARD_COUNT;
+
+    unsigned short* const cells = &state->cells[side][subBoard];
+    *cells |= (unsigned short)(1 << cell);
+    if (ultimateWinTable[*cells]) {
+        state->won[side] |= (unsigned short)(1 << subBoard);
+        state->decided |= (unsigned short)(1 << subBoard);
+    } else if ((*cells | state->cells[side ^ 1][subBoard]) == ULTIMATE_MASK_FULL) {
+        state->decided |= (unsigned short)(1 << subBoard);
+    }
+
+    state->key ^= ultimateTileKeys[side][tile] ^ ultimateForcedKeys[state->forcedBoard + 1];
+    state->forcedBoard = (signed char)(state->decided >> cell & 1 ? -1 : cell);
+    state->key ^= ultimateForcedKeys[state->forcedBoard + 1] ^ ultimateSideKey;
+    state->side ^= 1;
+}
+
+// Rebuilds the state from a tile board; `lastMove` (-1 before the first move) decides the forced sub-board.
+static inline void Ultimate_FromTiles(const BoardTile* board, BoardTile player, int lastMove, UltimateState* state) {
+    *state             = (UltimateState){ 0 };
+    state->forcedBoard = -1;
+    for (int i = 0; i < ULTIMATE_SIZE; ++i) {
+        if (board[i] == BoardTile_PlayerEmpty || i == lastMove) { continue; }
+        state->side = board[i] == BoardTile_PlayerOne ? 0 : 1;
+        Ultimate_Play(state, i);
+    }
+    // the last move is replayed last so that it sets the forced sub-board
+    if (lastMove >= 0) {
+        state->side = board[lastMove] == BoardTile_PlayerOne ? 0 : 1;
+        Ultimate_Play(state, lastMove);
+    }
+    state->side = player == BoardTile_PlayerOne ? 0 : 1;
+}
+
+static inline int Ultimate_GetMoves(const UltimateState* state, int* moves) {
+    int count = 0;
+    for (int subBoard = 0; subBoard < ULTIMATE_BOARD_COUNT; ++subBoard) {
+        if (state->decided >> subBoard & 1 || (state->forcedBoard >= 0 && state->forcedBoard != subBoard)) { continue; }
+        unsigned int empty = ~(state->cells[0][subBoard] | state->cells[1][subBoard]) & ULTIMATE_MASK_FULL;
+        while (empty) {
+            moves[count++] = subBoard * ULTIMATE_BOARD_COUNT + __builtin_ctz(empty);
+            empty &= empty - 1;
+        }
+    }
+    return count;
+}
+
+static inline bool Ultimate_IsLegalMove(const BoardTile* board, int lastMove, int tile) {
+    UltimateState state;
+    Ultimate_FromTiles(board, BoardTile_PlayerOne, lastMove, &state);
+    int moves[ULTIMATE_SIZE];
+    int moveCount = Ultimate_GetMoves(&state, moves);
+    for (int i = 0; i < moveCount; ++i) {
+        if (moves[i] == tile) { return true; }
+    }
+    return false;
+}
+
+// Same contract as Evaluate(): 1 if `player` won, -1 if `opponent` won, 0 for a draw, -2 while undecided.
+static inline int Ultimate_Evaluate(const BoardTile* board, BoardTile player, BoardTile opponent) {
+    (void)opponent;
+    UltimateState state;
+    Ultimate_FromTiles(board, player, -1, &state);
+    if (ultimateWinTable[state.won[state.side]]) { return 1; }
+    if (ultimateWinTable[state.won[state.side ^ 1]]) { return -1; }
+    if (state.decided == ULTIMATE_MASK_FULL) { return 0; }
+    return -2;
+}
+
+// #region Ultimate_Search
+static SearchCacheEntry ultimateCache[ULTIMATE_CACHE_SIZE];
+
+// Center, corners, then edges, for both the cells of a sub-board and the sub-boards themselves.
+static int const ultimatePlaceWeights[ULTIMATE_BOARD_COUNT] = { 3, 2, 3, 2, 4, 2, 3, 2, 3 };
+
+// Sub-board lines are worth more when the sub-board itself still helps `side` towards a line of sub-boards.
+static inline int Ultimate_EvaluateSide(const UltimateState* state, int side) {
+    static int const macroWeights[ULTIMATE_WIDTH] = { 0, 40, 250 };
+    static int const microWeights[ULTIMATE_WIDTH] = { 0, 1, 6 };
+
+    unsigned int const blocked = state->won[side ^ 1] | (state->decided & ~state->won[side]);
+    int                score   = 0;
+    for (int i = 0; i < ULTIMATE_LINE_COUNT; ++i) {
+        unsigned int const line = ultimateLineMasks[i];
+        if (!(line & blocked)) { score += macroWeights[Ultimate_CountBits(line & state->won[side])]; }
+    }
+    for (int subBoard = 0; subBoard < ULTIMATE_BOARD_COUNT; ++subBoard) {
+        if (state->won[side] >> subBoard & 1) {
+            score += 20 * ultimatePlaceWeights[subBoard];
+            continue;
+        }
+        if (state->decided >> subBoard & 1) { continue; }
+
+        unsigned int const mine   = state->cells[side][subBoard];
+        unsigned int const theirs = state->cells[side ^ 1][subBoard];
+        int                local  = 0;
+        for (int i = 0; i < ULTIMATE_LINE_COUNT; ++i) {
+            unsigned int const line = ultimateLineMasks[i];
+            if (!(line & theirs)) { local += microWeights[Ultimate_CountBits(line & mine)]; }
+        }
+        score += local * ultimatePlaceWeights[subBoard];
+    }
+    return score;
+}
+
+static inline int Ultimate_EvaluateStatic(const UltimateState* state) { return Ultimate_EvaluateSide(state, state->side) - Ultimate_EvaluateSide(state, state->side ^ 1); }
+
+// Move ordering: taking or saving a sub-board first, and sending the opponent where they can do neither last.
+static inline int Ultimate_ScoreMove(const UltimateState* state, int tile) {
+    int const          side     = state->side;
+    int const          subBoard = tile / ULTIMATE_BOARD_COUNT;
+    int const          cell     = tile % ULTIMATE_BOARD_COUNT;
+    unsigned int const mine     = state->cells[side][subBoard];
+    unsigned int const theirs   = state->cells[side ^ 1][subBoard];
+
+    int score = ultimatePlaceWeights[cell];
+    if (Ultimate_GetThreats(mine, theirs) >> cell & 1) { score += 1000; }
+    if (Ultimate_GetThreats(theirs, mine) >> cell & 1) { score += 500; }
+    if (cell != subBoard && state->decided >> cell & 1) {
+        score -= 300;
+    } else if (Ultimate_GetThreats(state->cells[side ^ 1][cell], state->cells[side][cell])) {
+        score -= 200;
+    }
+    return score;
+}
+
+static inline int Ultimate_OrderMoves(const UltimateState* state, int firstMove, int* moves) {
+    int       scores[ULTIMATE_SIZE];
+    int       candidates[ULTIMATE_SIZE];
+    int const count = Ultimate_GetMoves(state, candidates);
+    for (int i = 0; i < count; ++i) {
+        int const tile  = candidates[i];
+        int const score = tile == firstMove ? INT_MAX : Ultimate_ScoreMove(state, tile);
+
+        int slot = i;
+        for (; slot > 0 && scores[slot - 1] < score; --slot) {
+            scores[slot] = scores[slot - 1];
+            moves[slot]  = moves[slot - 1];
+        }
+        scores[slot] = score;
+        moves[slot]  = tile;
+    }
+    return count;
+}
+
+static inline int Ultimate_Negamax(SearchContext* search, const UltimateState* state, int depth, int alpha, int beta, int ply) { // NOLINT
+    if (Search_IsAborted(search)) { return 0; }
+
+    if (ultimateWinTable[state->won[state->side ^ 1]]) { return -(SEARCH_SCORE_WIN - ply); }
+    if (state->decided == ULTIMATE_MASK_FULL) { return 0; }
+    if (depth <= 0) { return Ultimate_EvaluateStatic(state); }
+
+    SearchCacheEntry* const entry      = Search_GetCacheEntry(search, state->key);
+    int                     cacheScore = 0;
+    int                     cacheMove  = -1;
+    if (Search_ProbeCache(search, entry, state->key, depth, ply, &alpha, &beta, &cacheScore, &cacheMove)) { return cacheScore; }
+
+    int       moves[ULTIMATE_SIZE];
+    int const moveCount   = Ultimate_OrderMoves(state, cacheMove, moves);
+    int const alphaOrigin = alpha;
+    int       bestScore   = -SEARCH_SCORE_INFINITY;
+    int       bestMove    = moves[0];
+    for (int i = 0; i < moveCount && alpha < beta; ++i) {
+        UltimateState next = *state;
+        Ultimate_Play(&next, moves[i]);
+        int const score = -Ultimate_Negamax(search, &next, depth - 1, -beta, -alpha, ply + 1);
+        if (search->isAborted) { return 0; }
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove  = moves[i];
+        }
+        alpha = max(alpha, score);
+    }
+
+    Search_StoreCache(search, entry, state->key, depth, ply, bestScore, alphaOrigin, beta, bestMove);
+    return bestScore;
+}
+
+static inline int Ultimate_SearchRootMove(SearchContext* search, const void* position, int move, int depth, int alpha) {
+    UltimateState next = *(UltimateState const*)position;
+    Ultimate_Play(&next, move);
+    return -Ultimate_Negamax(search, &next, depth - 1, -SEARCH_SCORE_INFINITY, -alpha, 1);
+}
+
+// Easy (difficulty 1) plays a random legal tile. Otherwise iterative deepening runs until a forced result
+// is found or ULTIMATE_TIME_BUDGET_MS runs out, and the best move of the last completed depth is played.
+static inline int Ultimate_GetAIMove(int difficulty, const BoardTile* board, BoardTile player, int lastMove) {
+    UltimateState state;
+    Ultimate_FromTiles(board, player, lastMove, &state);
+
+    int moves[ULTIMATE_SIZE] = { 0 };
+    if (difficulty == 1) {
+        int const moveCount = Ultimate_GetMoves(&state, moves);
+        return moves[rand() % moveCount]; // NOLINT
+    }
+
+    SearchContext search    = Search_Begin(ultimateCache, ULTIMATE_CACHE_SIZE, ULTIMATE_TIME_BUDGET_MS, ULTIMATE_SIZE);
+    int const     moveCount = Ultimate_OrderMoves(&state, -1, moves);
+    return Search_IterativeDeepening(&search, &state, Ultimate_SearchRootMove, moves, moveCount, ULTIMATE_DEPTH_MAX, "Ultimate_GetAIMove root move");
+}
+// #endregion // Ultimate_Search
+
+#endif // TIC_TAC_TOE_ULTIMATE_H